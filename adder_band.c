@@ -0,0 +1,570 @@
+/* band.c
+ * Function definitions for the banded, tridiagonal, and packed matrices in band.h */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy */
+#include <cblas.h>
+#include <lapacke.h>
+#include "adder_matrix.h"
+#include "adder_band.h"
+
+/* Band matrix functions */
+/* Create a band matrix from the elements of M within the band.
+ * Elements of M outside the band are ignored */
+adder_band_matrix *
+bandMatrixInit (adder_matrix *M, int kl, int ku)
+{
+	adder_band_matrix *B;
+	int i, j;
+
+	if (M->rows != M->columns) {
+		fprintf (stderr, "Dimension error:  Matrix not square.\n");
+		return NULL;
+	}
+
+	B = bandMatrixInit2 (M->rows, kl, ku);
+	if (B == 0x00) {
+		return NULL;
+	}
+
+	for (j = 0; j < B->n; j++) {
+		for (i = (j - ku > 0 ? j - ku : 0); i <= j + kl && i < B->n; i++) {
+			B->band[j * B->ldab + ku + i - j] = M->mat[i * M->columns + j];
+		}
+	}
+
+	return B;
+}
+
+/* Create an n x n band matrix with kl subdiagonals and ku superdiagonals set to zero */
+adder_band_matrix *
+bandMatrixInit2 (int n, int kl, int ku)
+{
+	adder_band_matrix *B;
+
+	if (n <= 0 || kl < 0 || ku < 0 || kl >= n || ku >= n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function bandMatrixInit2.\n");
+		return NULL;
+	}
+
+	B = malloc (sizeof (adder_band_matrix));
+	if (B == NULL) {
+		fprintf (stderr, "Failed to create band matrix.\n");
+		return NULL;
+	}
+
+	B->ldab = kl + ku + 1;
+	B->band = calloc ((long int)B->ldab * n, sizeof (double));
+	if (B->band == NULL) {
+		fprintf (stderr, "Failed to create band matrix.\n");
+		free (B);
+		return NULL;
+	}
+
+	B->n = n;
+	B->kl = kl;
+	B->ku = ku;
+
+	return B;
+}
+
+/* Delete a band matrix */
+void
+deleteBandMatrix (adder_band_matrix *B)
+{
+	free (B->band);
+	free (B);
+}
+
+/* Return element (i, j) of a band matrix, which is zero outside the band */
+double
+bandMatrixGet (adder_band_matrix *B, int i, int j)
+{
+	if (i < 0 || j < 0 || i >= B->n || j >= B->n || j - i > B->ku || i - j > B->kl) {
+		return 0;
+	}
+
+	return B->band[j * B->ldab + B->ku + i - j];
+}
+
+/* Set element (i, j) of a band matrix. Elements outside the band can't be set */
+int
+bandMatrixSet (adder_band_matrix *B, int i, int j, double value)
+{
+	if (i < 0 || j < 0 || i >= B->n || j >= B->n) {
+		fprintf (stderr, "ERROR:  Invalid index in function bandMatrixSet.\n");
+		return DIMENSION_ERROR;
+	}
+
+	if (j - i > B->ku || i - j > B->kl) {
+		fprintf (stderr, "ERROR:  Element (%d, %d) is outside the band in function bandMatrixSet.\n", i, j);
+		return ARGUMENT_ERROR;
+	}
+
+	B->band[j * B->ldab + B->ku + i - j] = value;
+
+	return 0;
+}
+
+/* Multiply a band matrix by a vector */
+adder_vector *
+mvMultiplyBand (adder_band_matrix *B, adder_vector *v)
+{
+	adder_vector *res;
+
+	if (v->orientation != COLUMN_VECTOR || v->size != B->n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function mvMultiplyBand.\n");
+		return NULL;
+	}
+
+	res = vectorInit2 (COLUMN_VECTOR, B->n);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	cblas_dgbmv (CblasColMajor, CblasNoTrans, B->n, B->n, B->kl, B->ku, 1.0, B->band, B->ldab, v->vect, 1, 0.0, res->vect, 1);
+
+	return res;
+}
+
+/* Solve the band system B * x = b using LU factorization with partial pivoting.
+ * Pivoting can add up to kl extra superdiagonals, so the factorization is done
+ * in a copy with room for them and B is not overwritten. */
+adder_vector *
+bandSolve (adder_band_matrix *B, adder_vector *b)
+{
+	const int n = B->n;
+	const int ldw = 2 * B->kl + B->ku + 1;
+	adder_vector *res;
+	double *work;
+	lapack_int *ipvt;
+	lapack_int err;
+	int j;
+
+	if (b->orientation != COLUMN_VECTOR || b->size != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function bandSolve.\n");
+		return NULL;
+	}
+
+	res = vectorInit (COLUMN_VECTOR, n, b->vect);
+	work = calloc ((long int)ldw * n, sizeof (double));
+	ipvt = malloc (n * sizeof (lapack_int));
+	if (res == 0x00 || work == 0x00 || ipvt == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function bandSolve.\n");
+		if (res != 0x00) {
+			deleteVector (res);
+		}
+		free (work);
+		free (ipvt);
+		return NULL;
+	}
+
+	/* The band goes below the kl rows left for fill-in */
+	for (j = 0; j < n; j++) {
+		memcpy (&work[(long int)j * ldw + B->kl], &B->band[(long int)j * B->ldab], B->ldab * sizeof (double));
+	}
+
+	err = LAPACKE_dgbsv (LAPACK_COL_MAJOR, n, B->kl, B->ku, 1, work, ldw, ipvt, res->vect, n);
+
+	free (work);
+	free (ipvt);
+
+	if (err < 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		deleteVector (res);
+		return NULL;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "ERROR:  Matrix is singular in function bandSolve.\n");
+		deleteVector (res);
+		return NULL;
+	}
+
+	return res;
+}
+
+/* Tridiagonal matrix functions */
+/* Create a tridiagonal matrix from its subdiagonal, diagonal, and superdiagonal.
+ * lower and upper have n - 1 elements and diag has n elements */
+adder_tridiagonal *
+tridiagonalInit (int n, double *lower, double *diag, double *upper)
+{
+	adder_tridiagonal *T;
+
+	T = tridiagonalInit2 (n);
+	if (T == 0x00) {
+		return NULL;
+	}
+
+	memcpy (T->lower, lower, (n - 1) * sizeof (double));
+	memcpy (T->diag, diag, n * sizeof (double));
+	memcpy (T->upper, upper, (n - 1) * sizeof (double));
+
+	return T;
+}
+
+/* Create an n x n tridiagonal matrix set to zero */
+adder_tridiagonal *
+tridiagonalInit2 (int n)
+{
+	adder_tridiagonal *T;
+
+	if (n <= 0) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function tridiagonalInit2.\n");
+		return NULL;
+	}
+
+	T = malloc (sizeof (adder_tridiagonal));
+	if (T == NULL) {
+		fprintf (stderr, "Failed to create tridiagonal matrix.\n");
+		return NULL;
+	}
+
+	/* All three diagonals share one allocation */
+	T->diag = calloc (3 * n, sizeof (double));
+	if (T->diag == NULL) {
+		fprintf (stderr, "Failed to create tridiagonal matrix.\n");
+		free (T);
+		return NULL;
+	}
+
+	T->lower = T->diag + n;
+	T->upper = T->lower + n;
+	T->n = n;
+
+	return T;
+}
+
+/* Delete a tridiagonal matrix */
+void
+deleteTridiagonal (adder_tridiagonal *T)
+{
+	free (T->diag);
+	free (T);
+}
+
+/* Multiply a tridiagonal matrix by a vector */
+adder_vector *
+mvMultiplyTridiagonal (adder_tridiagonal *T, adder_vector *v)
+{
+	const int n = T->n;
+	adder_vector *res;
+	double *x;
+	double *y;
+	int i;
+
+	if (v->orientation != COLUMN_VECTOR || v->size != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function mvMultiplyTridiagonal.\n");
+		return NULL;
+	}
+
+	res = vectorInit2 (COLUMN_VECTOR, n);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	x = v->vect;
+	y = res->vect;
+
+	y[0] = T->diag[0] * x[0];
+	#pragma omp simd
+	for (i = 1; i < n; i++) {
+		y[i] = T->lower[i - 1] * x[i - 1] + T->diag[i] * x[i];
+	}
+
+	#pragma omp simd
+	for (i = 0; i < n - 1; i++) {
+		y[i] += T->upper[i] * x[i + 1];
+	}
+
+	return res;
+}
+
+/* Solve the tridiagonal system T * x = b.
+ * This is Gaussian elimination with partial pivoting, which is as fast as the
+ * Thomas algorithm but also stable when T isn't diagonally dominant.
+ * T is not overwritten. */
+adder_vector *
+tridiagonalSolve (adder_tridiagonal *T, adder_vector *b)
+{
+	const int n = T->n;
+	adder_vector *res;
+	double *work;
+	lapack_int err;
+
+	if (b->orientation != COLUMN_VECTOR || b->size != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function tridiagonalSolve.\n");
+		return NULL;
+	}
+
+	res = vectorInit (COLUMN_VECTOR, n, b->vect);
+	work = malloc (3 * n * sizeof (double));
+	if (res == 0x00 || work == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function tridiagonalSolve.\n");
+		if (res != 0x00) {
+			deleteVector (res);
+		}
+		free (work);
+		return NULL;
+	}
+
+	/* Same layout as T so one copy is enough */
+	memcpy (work, T->diag, 3 * n * sizeof (double));
+
+	err = LAPACKE_dgtsv (LAPACK_COL_MAJOR, n, 1, work + n, work, work + 2 * n, res->vect, n);
+
+	free (work);
+
+	if (err < 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		deleteVector (res);
+		return NULL;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "ERROR:  Matrix is singular in function tridiagonalSolve.\n");
+		deleteVector (res);
+		return NULL;
+	}
+
+	return res;
+}
+
+/* Packed matrix functions */
+/* Return the index of element (i, j) in the packed storage of P,
+ * or -1 if it is in the triangle that isn't stored */
+static long int
+packedIndex (adder_packed_matrix *P, int i, int j)
+{
+	int swap;
+
+	if (P->type == PACKED_SYMMETRIC && i > j) {
+		swap = i;
+		i = j;
+		j = swap;
+	}
+
+	if (P->type == PACKED_LOWER_TRIANGULAR) {
+		if (i < j) {
+			return -1;
+		}
+
+		return i + (long int)j * (2 * P->n - j - 1) / 2;
+	}
+
+	if (i > j) {
+		return -1;
+	}
+
+	return i + (long int)j * (j + 1) / 2;
+}
+
+/* Create a packed matrix from the upper or lower triangle of M.
+ * Symmetric matrices are created from the upper triangle */
+adder_packed_matrix *
+packedMatrixInit (adder_matrix *M, int type)
+{
+	adder_packed_matrix *P;
+	long int k;
+	int i, j;
+
+	if (M->rows != M->columns) {
+		fprintf (stderr, "Dimension error:  Matrix not square.\n");
+		return NULL;
+	}
+
+	P = packedMatrixInit2 (M->rows, type);
+	if (P == 0x00) {
+		return NULL;
+	}
+
+	for (j = 0; j < P->n; j++) {
+		for (i = 0; i < P->n; i++) {
+			k = packedIndex (P, i, j);
+			if (k >= 0 && (type != PACKED_SYMMETRIC || i <= j)) {
+				P->packed[k] = M->mat[i * M->columns + j];
+			}
+		}
+	}
+
+	return P;
+}
+
+/* Create an n x n packed matrix set to zero */
+adder_packed_matrix *
+packedMatrixInit2 (int n, int type)
+{
+	adder_packed_matrix *P;
+
+	if (n <= 0) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function packedMatrixInit2.\n");
+		return NULL;
+	}
+
+	if (type != PACKED_SYMMETRIC && type != PACKED_UPPER_TRIANGULAR && type != PACKED_LOWER_TRIANGULAR) {
+		fprintf (stderr, "ERROR:  Invalid packed matrix type in function packedMatrixInit2.\n");
+		return NULL;
+	}
+
+	P = malloc (sizeof (adder_packed_matrix));
+	if (P == NULL) {
+		fprintf (stderr, "Failed to create packed matrix.\n");
+		return NULL;
+	}
+
+	P->packed = calloc ((long int)n * (n + 1) / 2, sizeof (double));
+	if (P->packed == NULL) {
+		fprintf (stderr, "Failed to create packed matrix.\n");
+		free (P);
+		return NULL;
+	}
+
+	P->n = n;
+	P->type = type;
+
+	return P;
+}
+
+/* Delete a packed matrix */
+void
+deletePackedMatrix (adder_packed_matrix *P)
+{
+	free (P->packed);
+	free (P);
+}
+
+/* Return element (i, j) of a packed matrix */
+double
+packedMatrixGet (adder_packed_matrix *P, int i, int j)
+{
+	long int k;
+
+	if (i < 0 || j < 0 || i >= P->n || j >= P->n) {
+		return 0;
+	}
+
+	k = packedIndex (P, i, j);
+
+	return k >= 0 ? P->packed[k] : 0;
+}
+
+/* Set element (i, j) of a packed matrix. For symmetric matrices
+ * this also sets element (j, i) */
+int
+packedMatrixSet (adder_packed_matrix *P, int i, int j, double value)
+{
+	long int k;
+
+	if (i < 0 || j < 0 || i >= P->n || j >= P->n) {
+		fprintf (stderr, "ERROR:  Invalid index in function packedMatrixSet.\n");
+		return DIMENSION_ERROR;
+	}
+
+	k = packedIndex (P, i, j);
+	if (k < 0) {
+		fprintf (stderr, "ERROR:  Element (%d, %d) is outside the triangle in function packedMatrixSet.\n", i, j);
+		return ARGUMENT_ERROR;
+	}
+
+	P->packed[k] = value;
+
+	return 0;
+}
+
+/* Multiply a packed matrix by a vector */
+adder_vector *
+mvMultiplyPacked (adder_packed_matrix *P, adder_vector *v)
+{
+	adder_vector *res;
+
+	if (v->orientation != COLUMN_VECTOR || v->size != P->n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function mvMultiplyPacked.\n");
+		return NULL;
+	}
+
+	if (P->type == PACKED_SYMMETRIC) {
+		res = vectorInit2 (COLUMN_VECTOR, P->n);
+		if (res == 0x00) {
+			return NULL;
+		}
+
+		cblas_dspmv (CblasColMajor, CblasUpper, P->n, 1.0, P->packed, v->vect, 1, 0.0, res->vect, 1);
+	}
+	else {
+		/* Triangular products are done in place */
+		res = vectorInit (COLUMN_VECTOR, P->n, v->vect);
+		if (res == 0x00) {
+			return NULL;
+		}
+
+		cblas_dtpmv (CblasColMajor, P->type == PACKED_UPPER_TRIANGULAR ? CblasUpper : CblasLower, CblasNoTrans, CblasNonUnit, P->n, P->packed, res->vect, 1);
+	}
+
+	return res;
+}
+
+/* Solve the packed system P * x = b.
+ * Triangular systems are solved by substitution. Symmetric systems are
+ * solved by Cholesky factorization if P is positive definite, and otherwise
+ * by the symmetric indefinite (Bunch-Kaufman) factorization.
+ * P is not overwritten. */
+adder_vector *
+packedSolve (adder_packed_matrix *P, adder_vector *b)
+{
+	const int n = P->n;
+	const long int size = (long int)n * (n + 1) / 2;
+	adder_vector *res;
+	double *work;
+	lapack_int *ipvt;
+	lapack_int err;
+
+	if (b->orientation != COLUMN_VECTOR || b->size != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function packedSolve.\n");
+		return NULL;
+	}
+
+	res = vectorInit (COLUMN_VECTOR, n, b->vect);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	if (P->type != PACKED_SYMMETRIC) {
+		err = LAPACKE_dtptrs (LAPACK_COL_MAJOR, P->type == PACKED_UPPER_TRIANGULAR ? 'U' : 'L', 'N', 'N', n, 1, P->packed, res->vect, n);
+	}
+	else {
+		work = malloc (size * sizeof (double));
+		ipvt = malloc (n * sizeof (lapack_int));
+		if (work == 0x00 || ipvt == 0x00) {
+			fprintf (stderr, "ERROR:  Failed to create workspace in function packedSolve.\n");
+			free (work);
+			free (ipvt);
+			deleteVector (res);
+			return NULL;
+		}
+
+		memcpy (work, P->packed, size * sizeof (double));
+		err = LAPACKE_dppsv (LAPACK_COL_MAJOR, 'U', n, 1, work, res->vect, n);
+
+		/* Not positive definite, so try the indefinite factorization */
+		if (err > 0) {
+			memcpy (work, P->packed, size * sizeof (double));
+			memcpy (res->vect, b->vect, n * sizeof (double));
+			err = LAPACKE_dspsv (LAPACK_COL_MAJOR, 'U', n, 1, work, ipvt, res->vect, n);
+		}
+
+		free (work);
+		free (ipvt);
+	}
+
+	if (err < 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		deleteVector (res);
+		return NULL;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "ERROR:  Matrix is singular in function packedSolve.\n");
+		deleteVector (res);
+		return NULL;
+	}
+
+	return res;
+}
@@ -0,0 +1,80 @@
+/* band.h
+ * Banded, tridiagonal, and packed matrix types.
+ *
+ * These store only the nonzero part of structured matrices, so memory use is
+ * O(n * bandwidth) instead of O(n^2), and matrix-vector products and solves
+ * cost O(n * bandwidth) or O(n^2) instead of the O(n^3) of a dense solve.
+ *
+ * Banded and packed matrices use the column-major layouts from LAPACK so that
+ * BLAS and LAPACK can work on them directly without transposing. */
+#ifndef ADDER_BAND_H
+#define ADDER_BAND_H
+
+#include "adder_matrix.h"
+
+enum
+PACKED_TYPE
+{
+	PACKED_SYMMETRIC = 1,
+	PACKED_UPPER_TRIANGULAR = 2,
+	PACKED_LOWER_TRIANGULAR = 3
+};
+
+/* Band matrix type definition.
+ * Element (i, j) with -kl <= j - i <= ku is stored in band[j * ldab + ku + i - j],
+ * so each column of the matrix is contiguous and each row of the storage is a diagonal. */
+typedef struct
+{
+	double *band;
+	int n; /* Number of rows and columns */
+	int kl; /* Number of subdiagonals */
+	int ku; /* Number of superdiagonals */
+	int ldab; /* Leading dimension of band, kl + ku + 1 */
+} adder_band_matrix;
+
+/* Tridiagonal matrix type definition */
+typedef struct
+{
+	double *lower; /* Subdiagonal, n - 1 elements */
+	double *diag; /* Diagonal, n elements */
+	double *upper; /* Superdiagonal, n - 1 elements */
+	int n; /* Number of rows and columns */
+} adder_tridiagonal;
+
+/* Packed matrix type definition.
+ * Symmetric matrices store their upper triangle. Element (i, j) of an upper
+ * triangle is stored in packed[i + j * (j + 1) / 2] and element (i, j) of a
+ * lower triangle is stored in packed[i + j * (2 * n - j - 1) / 2]. */
+typedef struct
+{
+	double *packed; /* n * (n + 1) / 2 elements */
+	int n; /* Number of rows and columns */
+	int type; /* One of PACKED_TYPE */
+} adder_packed_matrix;
+
+/* Band matrix functions */
+adder_band_matrix * bandMatrixInit (adder_matrix *M, int kl, int ku);
+adder_band_matrix * bandMatrixInit2 (int n, int kl, int ku);
+void deleteBandMatrix (adder_band_matrix *B);
+double bandMatrixGet (adder_band_matrix *B, int i, int j);
+int bandMatrixSet (adder_band_matrix *B, int i, int j, double value);
+adder_vector * mvMultiplyBand (adder_band_matrix *B, adder_vector *v);
+adder_vector * bandSolve (adder_band_matrix *B, adder_vector *b);
+
+/* Tridiagonal matrix functions */
+adder_tridiagonal * tridiagonalInit (int n, double *lower, double *diag, double *upper);
+adder_tridiagonal * tridiagonalInit2 (int n);
+void deleteTridiagonal (adder_tridiagonal *T);
+adder_vector * mvMultiplyTridiagonal (adder_tridiagonal *T, adder_vector *v);
+adder_vector * tridiagonalSolve (adder_tridiagonal *T, adder_vector *b);
+
+/* Packed matrix functions */
+adder_packed_matrix * packedMatrixInit (adder_matrix *M, int type);
+adder_packed_matrix * packedMatrixInit2 (int n, int type);
+void deletePackedMatrix (adder_packed_matrix *P);
+double packedMatrixGet (adder_packed_matrix *P, int i, int j);
+int packedMatrixSet (adder_packed_matrix *P, int i, int j, double value);
+adder_vector * mvMultiplyPacked (adder_packed_matrix *P, adder_vector *v);
+adder_vector * packedSolve (adder_packed_matrix *P, adder_vector *b);
+
+#endif
@@ -3,11 +3,8 @@
  */
 #include <stdio.h>
 #include <stdlib.h> /* For malloc and free */
-#include <math.h> /* For sqrt and log */
 #include "adder_complex.h"
 
-#define M_PI 3.14159265358979323846
-
 /*********************************
  * Initialize and delete numbers *
  *********************************/
@@ -218,39 +215,14 @@ clearPolar (adder_complex_polar *num)
 void
 rect2polar (adder_complex_rect *rectNum, adder_complex_polar *polarNum)
 {
-	/* Calculate the magnitude of the rectangular number */
-	polarNum->mag = sqrt ((rectNum->real * rectNum->real) + (rectNum->imag * rectNum->imag));
-
-	/* Calculate the angle of the number */
-	if (rectNum->imag == 0 && rectNum->real != 0) {
-		polarNum->angle = 0;
-	}
-	else if (rectNum->imag > 0 && rectNum->real == 0) {
-		polarNum->angle = M_PI / 2;
-	}
-	else if (rectNum->imag < 0 && rectNum->real == 0) {
-		polarNum->angle = -1 * M_PI / 2;
-	}
-	else if (rectNum->imag > 0 && rectNum->real > 0) {
-		polarNum->angle = atan (rectNum->imag / rectNum->real);
-	}
-	else if (rectNum->imag > 0 && rectNum->real < 0) {
-		polarNum->angle = (M_PI / 2) +  atan (-1 * rectNum->imag / rectNum->real);
-	}
-	else if (rectNum->imag < 0 && rectNum->real < 0) {
-		polarNum->angle = M_PI + atan (rectNum->imag / rectNum->real);
-	}
-	else if (rectNum->imag < 0 && rectNum->real > 0) {
-		polarNum->angle = -1 * atan (-1 * rectNum->imag / rectNum->real);
-	}
+	*polarNum = toPolar (*rectNum);
 }
 
 /* Convert a polar number to rectangular */
 void
 polar2rect (adder_complex_rect *rectNum, adder_complex_polar *polarNum)
 {
-	rectNum->real = polarNum->mag * cos (polarNum->angle);
-	rectNum->imag = polarNum->angle * sin (polarNum->angle);
+	*rectNum = toRect (*polarNum);
 }
 
 /************************************
@@ -261,40 +233,35 @@ polar2rect (adder_complex_rect *rectNum, adder_complex_polar *polarNum)
 void
 addRect (adder_complex_rect *sum, adder_complex_rect *n1, adder_complex_rect *n2)
 {
-	sum->real = n1->real + n2->real;
-	sum->imag = n1->imag + n2->imag;
+	*sum = rectAdd (*n1, *n2);
 }
 
 /* Subtract two rectangular numbers */
 void
 subRect (adder_complex_rect *diff, adder_complex_rect *n1, adder_complex_rect *n2)
 {
-	diff->real = n1->real - n2->real;
-	diff->imag = n1->imag - n2->imag;
+	*diff = rectSub (*n1, *n2);
 }
 
 /* Multiply two rectangular numbers */
 void
 multRect (adder_complex_rect *prod, adder_complex_rect *n1, adder_complex_rect *n2)
 {
-	prod->real = n1->real * n2->real - n1->imag * n2->imag;
-	prod->imag = n1->real * n2->imag + n1->imag * n2->real;
+	*prod = rectMul (*n1, *n2);
 }
 
 /* Divide two rectangular numbers */
 void
 divRect (adder_complex_rect *quot, adder_complex_rect *n1, adder_complex_rect *n2)
 {
-	quot->real = (n1->real * n2->real + n1->imag * n2->imag) / (n2->real * n2->real + n2->imag * n2->imag);
-	quot->imag = (n2->real * n1->imag - n2->imag * n1->real) / (n2->real * n2->real + n2->imag * n2->imag);
+	*quot = rectDiv (*n1, *n2);
 }
 
 /* Find the reciprocal of the number */
 void
 invRect (adder_complex_rect *result, adder_complex_rect *num)
 {
-	result->real = num->real / (num->real * num->real + num->imag * num->imag);
-	result->imag = -1 * num->imag / (num->real * num->real + num->imag * num->imag);
+	*result = rectInv (*num);
 }
 
 /* Find the square root of a rectangular number.
@@ -302,19 +269,7 @@ invRect (adder_complex_rect *result, adder_complex_rect *num)
 void
 sqrtRect (adder_complex_rect *result, adder_complex_rect *num)
 {
-	double r, angle;
-
-	/* Get the magnitude and calculate its square root */
-	r = magRect (num);
-	r = sqrt (r);
-
-	/* Get the angle and divide it by two */
-	angle = angleRect (num);
-	angle /= 2;
-
-	/* Now convert the magnitude and angle to a rectangular number */
-	result->real = r * cos (angle);
-	result->imag = r * sin (angle);
+	*result = rectSqrt (*num);
 }
 
 /* Find the natural log of a rectangular number.
@@ -322,15 +277,7 @@ sqrtRect (adder_complex_rect *result, adder_complex_rect *num)
 void
 logRect (adder_complex_rect *result, adder_complex_rect *num)
 {
-	double r, angle;
-
-	/* Calculate the magnitude and ahgle of the number */
-	r = magRect (num);
-	angle = angleRect (num);
-
-	/* Calculate the solution */
-	result->real = log (r);
-	result->imag = angle;
+	*result = rectLog (*num);
 }
 
 /* Calculate the complex conjugate of the number.
@@ -338,51 +285,21 @@ logRect (adder_complex_rect *result, adder_complex_rect *num)
 void
 conjRect (adder_complex_rect *res, adder_complex_rect *num)
 {
-	res->imag = -1 * num->imag;
+	*res = rectConj (*num);
 }
 
 /* Calculate the magnitude of a rectangular number */
 double
 magRect (adder_complex_rect *num)
 {
-	return sqrt ((num->real * num->real) + (num->imag * num->imag));
+	return rectMag (*num);
 }
 
 /* Calculate the angle of a rectangular number in radians */
 double
 angleRect (adder_complex_rect *num)
 {
-	if (num->real == 0 && num->imag == 0) {
-		return 0;
-	}
-
-	else if (num->real > 0) {
-		if (num->imag == 0) {
-			return M_PI / 2;
-		}
-
-		else if (num->imag > 0) {
-			return atan (num->imag / num->real);
-		}
-
-		else {
-			return -1 * atan (-1 * num->imag / num->real);
-		}
-	}
-
-	else {
-		if (num->imag == 0) {
-			return M_PI / 2;
-		}
-
-		else if (num->imag > 0) {
-			return M_PI - atan (num->imag / (-1 * num->real));
-		}
-
-		else {
-			return M_PI + atan (num->imag / num->real);
-		}
-	}
+	return rectAngle (*num);
 }
 
 /******************************
@@ -395,37 +312,7 @@ angleRect (adder_complex_rect *num)
 int
 addPolar (adder_complex_polar *sum, adder_complex_polar *num1, adder_complex_polar *num2)
 {
-	double r1, i1;
-	double r2, i2;
-	double r, i;
-	double m, a;
-	adder_complex_rect *res;
-
-	res = initRect2 ();
-	if (res == NULL) {
-		fprintf (stderr, "ERROR:  Cannot create number for intermediate solution.\n");
-		return COMPLEX_ERROR;
-	}
-
-	/* Calculate the real and imaginary parts of the two numbers being added */
-	r1 = realPolar (num1);
-	i1 = imagPolar (num1);
-	r2 = realPolar (num2);
-	i2 = imagPolar (num2);
-
-	/* Perform the addition */
-	r = r1 + r2;
-	i = i1 + i2;
-	setReal (res, r);
-	setImag (res, i);
-
-	/* Convert the result back to polar form */
-	m = magRect (res);
-	a = angleRect (res);
-	setMag (sum, m);
-	setAngle (sum, a);
-
-	deleteRect (res);
+	*sum = polarAdd (*num1, *num2);
 
 	return COMPLEX_SUCCESS;
 }
@@ -436,37 +323,7 @@ addPolar (adder_complex_polar *sum, adder_complex_polar *num1, adder_complex_pol
 int
 subPolar (adder_complex_polar *diff, adder_complex_polar *num1, adder_complex_polar *num2)
 {
-	double r1, i1;
-	double r2, i2;
-	double r, i;
-	double m, a;
-	adder_complex_rect *res;
-
-	res = initRect2 ();
-	if (res == NULL) {
-		fprintf (stderr, "ERROR:  Cannot create number for intermediate solution.\n");
-		return COMPLEX_ERROR;
-	}
-
-	/* Calculate the real and imaginary parts of the two numbers being subtracted */
-	r1 = realPolar (num1);
-	i1 = imagPolar (num1);
-	r2 = realPolar (num2);
-	i2 = imagPolar (num2);
-
-	/* Perform the subtraction */
-	r = r1 - r2;
-	i = i1 - i2;
-	setReal (res, r);
-	setImag (res, i);
-
-	/* Convert the result back to polar form */
-	m = magRect (res);
-	a = angleRect (res);
-	setMag (diff, m);
-	setAngle (diff, a);
-
-	free (res);
+	*diff = polarSub (*num1, *num2);
 
 	return COMPLEX_SUCCESS;
 }
@@ -476,13 +333,7 @@ subPolar (adder_complex_polar *diff, adder_complex_polar *num1, adder_complex_po
 void
 multPolar (adder_complex_polar *prod, adder_complex_polar *num1, adder_complex_polar *num2)
 {
-	double m, a;
-
-	m = num1->mag * num2->mag;
-	a = num1->angle + num2->angle;
-
-	setMag (prod, m);
-	setAngle (prod, a);
+	*prod = polarMul (*num1, *num2);
 }
 
 /* Divide two polar numbers.
@@ -490,21 +341,15 @@ multPolar (adder_complex_polar *prod, adder_complex_polar *num1, adder_complex_p
 void
 divPolar (adder_complex_polar *quot, adder_complex_polar *num1, adder_complex_polar *num2)
 {
-	double m, a;
-
-	m = num1->mag / num2->mag;
-	a = num1->angle - num2->angle;
-
-	setMag (quot, m);
-	setAngle (quot, a);
+	*quot = polarDiv (*num1, *num2);
 }
 
 /* Calculate the inverse of a polar number.
- * This is defined as keeping the magnitude and multiplying the angle by -1 */
+ * This is defined as inverting the magnitude and multiplying the angle by -1 */
 void
 invPolar (adder_complex_polar *res, adder_complex_polar *num)
 {
-	res->angle = -1 * num->angle;
+	*res = polarInv (*num);
 }
 
 /* Calculate the square root of a polar number.
@@ -512,29 +357,38 @@ invPolar (adder_complex_polar *res, adder_complex_polar *num)
 void
 sqrtPolar (adder_complex_polar *res, adder_complex_polar *num)
 {
-	res->mag = sqrt (num->mag);
-	res->angle = num->angle / 2;
+	*res = polarSqrt (*num);
 }
 
 /* Calculate the natural log of a polar number.
- * This is defined as Log(z) = ln(r) + j theta */
+ * This is defined as Log(z) = ln(r) + j theta, which is returned in polar form */
 void
 logPolar (adder_complex_polar *res, adder_complex_polar *num)
 {
-	res->mag = log (num->mag);
-	res->angle = num->angle;
+	*res = polarLog (*num);
 }
 
 /* Calculate the real part of a polar number */
 double
 realPolar (adder_complex_polar *num)
 {
-	return num->mag * cos (num->angle);
+	return polarReal (*num);
 }
 
 /* Calculate the imaginary part of a polar number */
 double
 imagPolar (adder_complex_polar *num)
 {
-	return num->mag * sin (num->angle);
+	return polarImag (*num);
+}
+
+/*******************
+ * Other functions *
+ *******************/
+
+/* Calculate e^(jx) = cos(x) + j sin(x) */
+void
+complexExp (adder_complex_rect *result, double x)
+{
+	*result = rectExp (makeRect (0, x));
 }
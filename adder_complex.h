@@ -82,4 +82,7 @@ void complexExp (adder_complex_rect *result, double x);
 void rect2polar (adder_complex_rect *rectNum, adder_complex_polar *polNum);
 void polar2rect (adder_complex_rect *rectNum, adder_complex_polar *polNum);
 
+/* Inline functions on values */
+#include "adder_complex_inline.h"
+
 #endif
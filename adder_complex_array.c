@@ -0,0 +1,909 @@
+/* complex_array.c
+ * Function definitions for the elementwise complex functions in complex_array.h */
+#include <stdio.h>
+#include <float.h> /* For DBL_MIN and DBL_MAX */
+#include <string.h> /* For memcpy */
+#include <math.h>
+#include "adder_complex.h"
+#include "adder_matrix.h"
+#include "adder_complex_array.h"
+
+/* Number of elements each kernel call works on. Small enough that a block
+ * read twice is still in the L1 cache the second time */
+#define COMPLEX_ARRAY_BLOCK 1024
+
+#define PI 3.14159265358979323846
+#define PI_2 1.57079632679489661923
+#define PI_4 0.78539816339744830962
+#define TWO_OVER_PI 0.63661977236758134308
+
+/* The branch-free atan2 and sincos use GCC vector extensions, which clang
+ * and other compilers don't fully support. They get plain loops over the
+ * inline scalar functions instead */
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER)
+#define ARRAY_VECTOR_MATH
+#endif
+
+/* Kernels are compiled once per instruction set and the loader picks the
+ * version for the running processor. This needs ifunc support, which glibc
+ * has and musl and macOS don't */
+#if defined(ARRAY_VECTOR_MATH) && defined(__x86_64__) && defined(__GLIBC__)
+#define ARRAY_KERNEL __attribute__((target_clones ("avx512f", "avx2", "default")))
+#else
+#define ARRAY_KERNEL
+#endif
+
+/* Angles larger than this are reduced by the math library, since the
+ * three-part reduction by pi/2 below loses accuracy past it */
+#define SINCOS_REDUCTION_LIMIT 1e6
+
+typedef void (*binary_kernel) (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n);
+typedef void (*unary_kernel) (adder_complex_rect *res, adder_complex_rect *a, int n);
+typedef void (*real_kernel) (double *res, adder_complex_rect *a, int n);
+typedef void (*polar_kernel) (adder_complex_polar *res, adder_complex_rect *a, int n);
+typedef void (*rect_kernel) (adder_complex_rect *res, adder_complex_polar *a, int n);
+
+#ifdef ARRAY_VECTOR_MATH
+
+/*********************************
+ * Branch-free atan2 and sincos  *
+ *********************************/
+
+/* atan2 and sin/cos work on VECTOR_LENGTH values at once with GCC vector
+ * types. Conditions are masks, both sides of each condition are calculated,
+ * and the results are merged, so there are no branches and each kernel
+ * clone uses its widest registers. Vectors are passed by pointer, since
+ * passing them by value draws ABI warnings from GCC in the clones without
+ * AVX-512. The polynomials are from the Cephes library. */
+#define VECTOR_LENGTH 8
+
+typedef double vector_double __attribute__((vector_size (VECTOR_LENGTH * sizeof (double))));
+typedef long long vector_mask __attribute__((vector_size (VECTOR_LENGTH * sizeof (long long))));
+
+/* Vector with every element equal to c */
+#define VECTOR_CONSTANT(c) ((vector_double){0} + (c))
+
+/* Elements of a where mask is set and of b elsewhere */
+#define VECTOR_SELECT(mask, a, b) ((vector_double)(((mask) & (vector_mask)(a)) | (~(mask) & (vector_mask)(b))))
+
+#define VECTOR_ABS(a) ((vector_double)((vector_mask)(a) & 0x7fffffffffffffffLL))
+
+/* Deinterleave VECTOR_LENGTH complex numbers into their two parts */
+static inline __attribute__((always_inline)) void
+vectorLoadPairs (double *p, vector_double *first, vector_double *second)
+{
+	vector_double lo, hi;
+
+	memcpy (&lo, p, sizeof (vector_double));
+	memcpy (&hi, p + VECTOR_LENGTH, sizeof (vector_double));
+
+	*first = __builtin_shuffle (lo, hi, (vector_mask){0, 2, 4, 6, 8, 10, 12, 14});
+	*second = __builtin_shuffle (lo, hi, (vector_mask){1, 3, 5, 7, 9, 11, 13, 15});
+}
+
+static inline __attribute__((always_inline)) void
+vectorStorePairs (double *p, vector_double *first, vector_double *second)
+{
+	vector_double lo = __builtin_shuffle (*first, *second, (vector_mask){0, 8, 1, 9, 2, 10, 3, 11});
+	vector_double hi = __builtin_shuffle (*first, *second, (vector_mask){4, 12, 5, 13, 6, 14, 7, 15});
+
+	memcpy (p, &lo, sizeof (vector_double));
+	memcpy (p + VECTOR_LENGTH, &hi, sizeof (vector_double));
+}
+
+/* res = atan2 (y, x). COMPLEX_ACCURACY_FULL has an error of a few units in
+ * the last place, and COMPLEX_ACCURACY_FAST an absolute error below 1e-7 */
+static inline __attribute__((always_inline)) void
+vectorAtan2 (vector_double *res, vector_double *y, vector_double *x, int accuracy)
+{
+	const vector_double one = VECTOR_CONSTANT (1);
+	vector_double ax = VECTOR_ABS (*x);
+	vector_double ay = VECTOR_ABS (*y);
+	vector_mask swap = (vector_mask)(ay > ax);
+	vector_mask infinite = (vector_mask)((ax == INFINITY) & (ay == INFINITY));
+	vector_double hi = VECTOR_SELECT (swap, ay, ax);
+	vector_double lo = VECTOR_SELECT (swap, ax, ay);
+	vector_double t, u, z, r;
+	vector_mask upper;
+
+	/* atan (t) with 0 <= t <= 1, using 1 / 1 instead of inf / inf and
+	 * 0 / 1 instead of 0 / 0. NaNs pass through to the result */
+	hi = VECTOR_SELECT (infinite | (vector_mask)(hi == 0), one, hi);
+	lo = VECTOR_SELECT (infinite, one, lo);
+	t = lo / hi;
+
+	if (accuracy == COMPLEX_ACCURACY_FAST) {
+		/* Reduce to |u| <= tan (pi/8) */
+		upper = (vector_mask)(t > 0.41421356237309504880);
+		u = VECTOR_SELECT (upper, (t - 1) / (t + 1), t);
+		z = u * u;
+		r = (((8.05374449538e-2 * z - 1.38776856032e-1) * z + 1.99777106478e-1) * z - 3.33329491539e-1) * z * u + u;
+		r = VECTOR_SELECT (upper, PI_4 + r, r);
+	}
+	else {
+		vector_double p, q;
+
+		/* Reduce to |u| <= 0.66 */
+		upper = (vector_mask)(t > 0.66);
+		u = VECTOR_SELECT (upper, (t - 1) / (t + 1), t);
+		z = u * u;
+		p = (((-8.750608600031904122785e-1 * z - 1.615753718733365076637e1) * z - 7.500855792314704667340e1) * z - 1.228866684490136173410e2) * z - 6.485021904942025371773e1;
+		q = ((((z + 2.485846490142306297962e1) * z + 1.650270098316988542046e2) * z + 4.328810604912902668951e2) * z + 4.853903996359136964868e2) * z + 1.945506571482613964425e2;
+		r = u + u * z * p / q;
+		r = VECTOR_SELECT (upper, PI_4 + (r + 3.06161699786838301793e-17 * 0.5), r);
+	}
+
+	/* Undo the reduction to the first octant */
+	r = VECTOR_SELECT (swap, PI_2 - r, r);
+	r = VECTOR_SELECT ((vector_mask)*x < 0, PI - r, r);
+
+	/* copysign (r, y) */
+	*res = (vector_double)(((vector_mask)r & 0x7fffffffffffffffLL) | ((vector_mask)*y & ~0x7fffffffffffffffLL));
+}
+
+/* sin (x) and cos (x) for |x| <= SINCOS_REDUCTION_LIMIT, with the same
+ * accuracy as vectorAtan2 */
+static inline __attribute__((always_inline)) void
+vectorSincos (vector_double *sine, vector_double *cosine, vector_double *angle, int accuracy)
+{
+	vector_double x = *angle;
+	vector_double k, r, z, s, c;
+	vector_mask q, odd;
+
+	/* x = r + k * pi/2 with |r| <= pi/4. Adding 1.5 * 2^52 rounds to an
+	 * integer, which is left in the low bits of the sum */
+	k = x * TWO_OVER_PI + 0x1.8p52;
+	q = (vector_mask)k & 3;
+	k = k - 0x1.8p52;
+	r = ((x - k * 1.57079625129699707031) - k * 7.54978941586159635335e-8) - k * 5.39030285815811905290e-15;
+	z = r * r;
+
+	if (accuracy == COMPLEX_ACCURACY_FAST) {
+		s = r + r * z * ((-1.9515295891e-4 * z + 8.3321608736e-3) * z - 1.6666654611e-1);
+		c = 1 - 0.5 * z + z * z * ((2.443315711809948e-5 * z - 1.388731625493765e-3) * z + 4.166664568298827e-2);
+	}
+	else {
+		s = r + r * z * (((((1.58962301576546568060e-10 * z - 2.50507477628578072866e-8) * z + 2.75573136213857245213e-6) * z - 1.98412698295895385996e-4) * z + 8.33333333332211858878e-3) * z - 1.66666666666666307295e-1);
+		c = 1 - 0.5 * z + z * z * (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z - 2.75573141792967388112e-7) * z + 2.48015872888517045348e-5) * z - 1.38888888888730564116e-3) * z + 4.16666666666665929218e-2);
+	}
+
+	/* Rotate by k quarter turns */
+	odd = (vector_mask)((q & 1) != 0);
+	*sine = VECTOR_SELECT (odd, c, s);
+	*cosine = VECTOR_SELECT (odd, s, c);
+	*sine = VECTOR_SELECT ((vector_mask)((q & 2) != 0), -*sine, *sine);
+	*cosine = VECTOR_SELECT ((vector_mask)(((q + 1) & 2) != 0), -*cosine, *cosine);
+}
+
+/* Nonzero if every angle can be reduced by vectorSincos */
+static inline int
+anglesSafe (adder_complex_polar *a, int n)
+{
+	int i, bad = 0;
+
+	#pragma omp simd reduction(|:bad)
+	for (i = 0; i < n; i++) {
+		bad |= !(fabs (a[i].angle) <= SINCOS_REDUCTION_LIMIT);
+	}
+
+	return !bad;
+}
+
+#endif
+
+/*********************************
+ * Kernels on one block          *
+ *********************************/
+
+/* The kernels read both parts of an element before writing either, so res
+ * may be the same array as a or b */
+static ARRAY_KERNEL void
+addKernel (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	int i;
+
+	#pragma omp simd
+	for (i = 0; i < n; i++) {
+		res[i].real = a[i].real + b[i].real;
+		res[i].imag = a[i].imag + b[i].imag;
+	}
+}
+
+static ARRAY_KERNEL void
+subKernel (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	int i;
+
+	#pragma omp simd
+	for (i = 0; i < n; i++) {
+		res[i].real = a[i].real - b[i].real;
+		res[i].imag = a[i].imag - b[i].imag;
+	}
+}
+
+static ARRAY_KERNEL void
+mulKernel (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	int i;
+
+	#pragma omp simd
+	for (i = 0; i < n; i++) {
+		double ar = a[i].real;
+		double ai = a[i].imag;
+		double br = b[i].real;
+		double bi = b[i].imag;
+
+		res[i].real = ar * br - ai * bi;
+		res[i].imag = ar * bi + ai * br;
+	}
+}
+
+static ARRAY_KERNEL void
+divKernel (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	int i;
+
+	#pragma omp simd
+	for (i = 0; i < n; i++) {
+		double ar = a[i].real;
+		double ai = a[i].imag;
+		double br = b[i].real;
+		double bi = b[i].imag;
+		double d = 1 / (br * br + bi * bi);
+
+		res[i].real = (ar * br + ai * bi) * d;
+		res[i].imag = (ai * br - ar * bi) * d;
+	}
+}
+
+static ARRAY_KERNEL void
+conjKernel (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	int i;
+
+	#pragma omp simd
+	for (i = 0; i < n; i++) {
+		res[i].real = a[i].real;
+		res[i].imag = -a[i].imag;
+	}
+}
+
+/* Nonzero if real^2 + imag^2 neither overflows nor underflows for any
+ * element, so the magnitude can be calculated without hypot */
+static inline int
+magnitudeSafe (adder_complex_rect *a, int n)
+{
+	int i, bad = 0;
+
+	#pragma omp simd reduction(|:bad)
+	for (i = 0; i < n; i++) {
+		double s = a[i].real * a[i].real + a[i].imag * a[i].imag;
+
+		bad |= !(s >= DBL_MIN) | !(s <= DBL_MAX);
+	}
+
+	return !bad;
+}
+
+/* Blocks with zeros, infinities, NaNs, or extreme magnitudes use hypot.
+ * The square roots are only vectorized when sqrt doesn't have to set errno,
+ * so Adder should be built with -fno-math-errno */
+static ARRAY_KERNEL void
+absKernel (double *res, adder_complex_rect *a, int n)
+{
+	int i;
+
+	if (!magnitudeSafe (a, n)) {
+		for (i = 0; i < n; i++) {
+			res[i] = rectMag (a[i]);
+		}
+
+		return;
+	}
+
+	#pragma omp simd
+	for (i = 0; i < n; i++) {
+		res[i] = sqrt (a[i].real * a[i].real + a[i].imag * a[i].imag);
+	}
+}
+
+/* Principal square root without branches, the same method as rectSqrt */
+static ARRAY_KERNEL void
+sqrtKernel (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	int i;
+
+	if (!magnitudeSafe (a, n)) {
+		for (i = 0; i < n; i++) {
+			res[i] = rectSqrt (a[i]);
+		}
+
+		return;
+	}
+
+	#pragma omp simd
+	for (i = 0; i < n; i++) {
+		double re = a[i].real;
+		double im = a[i].imag;
+		double t = sqrt (0.5 * (sqrt (re * re + im * im) + fabs (re)));
+		double u = im / (2 * t);
+
+		res[i].real = re >= 0 ? t : fabs (u);
+		res[i].imag = re >= 0 ? u : copysign (t, im);
+	}
+}
+
+/* log comes from the math library one element at a time, so it is only threaded */
+static void
+logKernel (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		res[i] = rectLog (a[i]);
+	}
+}
+
+#ifdef ARRAY_VECTOR_MATH
+
+/* The remaining kernels work on groups of VECTOR_LENGTH elements. The last
+ * partial group is copied to a zero-padded buffer */
+
+/* e^a. The magnitudes come from exp in the math library. As in rectExp, a
+ * zero imaginary part is kept exactly, even when the magnitude is infinite */
+static inline __attribute__((always_inline)) void
+expGroup (adder_complex_rect *res, adder_complex_rect *a, double *m)
+{
+	vector_double re, im, s, c, mag;
+
+	vectorLoadPairs ((double *)a, &re, &im);
+	memcpy (&mag, m, sizeof (vector_double));
+	vectorSincos (&s, &c, &im, COMPLEX_ACCURACY_FULL);
+	c *= mag;
+	s = VECTOR_SELECT ((vector_mask)(im == 0), im, s * mag);
+	vectorStorePairs ((double *)res, &c, &s);
+}
+
+static ARRAY_KERNEL void
+expKernel (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	double m[COMPLEX_ARRAY_BLOCK];
+	adder_complex_rect pad[VECTOR_LENGTH] = {{0}};
+	int i, bad = 0;
+
+	for (i = 0; i < n; i++) {
+		m[i] = exp (a[i].real);
+		bad |= !(fabs (a[i].imag) <= SINCOS_REDUCTION_LIMIT);
+	}
+
+	if (bad) {
+		for (i = 0; i < n; i++) {
+			res[i] = rectExp (a[i]);
+		}
+
+		return;
+	}
+
+	for (i = 0; i + VECTOR_LENGTH <= n; i += VECTOR_LENGTH) {
+		expGroup (res + i, a + i, m + i);
+	}
+
+	if (i < n) {
+		memcpy (pad, a + i, (n - i) * sizeof (adder_complex_rect));
+		expGroup (pad, pad, m + i);
+		memcpy (res + i, pad, (n - i) * sizeof (adder_complex_rect));
+	}
+}
+
+/* Angles of a */
+static inline __attribute__((always_inline)) void
+argGroup (double *res, adder_complex_rect *a)
+{
+	vector_double re, im, angle;
+
+	vectorLoadPairs ((double *)a, &re, &im);
+	vectorAtan2 (&angle, &im, &re, COMPLEX_ACCURACY_FULL);
+	memcpy (res, &angle, sizeof (vector_double));
+}
+
+static ARRAY_KERNEL void
+argKernel (double *res, adder_complex_rect *a, int n)
+{
+	adder_complex_rect pad[VECTOR_LENGTH] = {{0}};
+	double out[VECTOR_LENGTH];
+	int i;
+
+	for (i = 0; i + VECTOR_LENGTH <= n; i += VECTOR_LENGTH) {
+		argGroup (res + i, a + i);
+	}
+
+	if (i < n) {
+		memcpy (pad, a + i, (n - i) * sizeof (adder_complex_rect));
+		argGroup (out, pad);
+		memcpy (res + i, out, (n - i) * sizeof (double));
+	}
+}
+
+/* Rectangular to polar. Magnitudes are calculated as in absKernel, and
+ * res must not overlap a */
+static inline __attribute__((always_inline)) void
+polarGroup (adder_complex_polar *res, adder_complex_rect *a, int accuracy)
+{
+	vector_double re, im, angle, mag;
+	double squares[VECTOR_LENGTH];
+	int j;
+
+	vectorLoadPairs ((double *)a, &re, &im);
+	vectorAtan2 (&angle, &im, &re, accuracy);
+	mag = re * re + im * im;
+	memcpy (squares, &mag, sizeof (vector_double));
+
+	for (j = 0; j < VECTOR_LENGTH; j++) {
+		squares[j] = sqrt (squares[j]);
+	}
+
+	memcpy (&mag, squares, sizeof (vector_double));
+	vectorStorePairs ((double *)res, &mag, &angle);
+}
+
+static inline __attribute__((always_inline)) void
+polarBlock (adder_complex_polar *res, adder_complex_rect *a, int n, int accuracy)
+{
+	adder_complex_rect pad[VECTOR_LENGTH] = {{0}};
+	adder_complex_polar out[VECTOR_LENGTH];
+	int i;
+
+	for (i = 0; i + VECTOR_LENGTH <= n; i += VECTOR_LENGTH) {
+		polarGroup (res + i, a + i, accuracy);
+	}
+
+	if (i < n) {
+		memcpy (pad, a + i, (n - i) * sizeof (adder_complex_rect));
+		polarGroup (out, pad, accuracy);
+		memcpy (res + i, out, (n - i) * sizeof (adder_complex_polar));
+	}
+
+	if (!magnitudeSafe (a, n)) {
+		for (i = 0; i < n; i++) {
+			res[i].mag = rectMag (a[i]);
+		}
+	}
+}
+
+static ARRAY_KERNEL void
+polarFullKernel (adder_complex_polar *res, adder_complex_rect *a, int n)
+{
+	polarBlock (res, a, n, COMPLEX_ACCURACY_FULL);
+}
+
+static ARRAY_KERNEL void
+polarFastKernel (adder_complex_polar *res, adder_complex_rect *a, int n)
+{
+	polarBlock (res, a, n, COMPLEX_ACCURACY_FAST);
+}
+
+/* Polar to rectangular. Blocks with huge or non-finite angles use the
+ * math library */
+static inline __attribute__((always_inline)) void
+rectGroup (adder_complex_rect *res, adder_complex_polar *a, int accuracy)
+{
+	vector_double mag, angle, s, c;
+
+	vectorLoadPairs ((double *)a, &mag, &angle);
+	vectorSincos (&s, &c, &angle, accuracy);
+	c *= mag;
+	s *= mag;
+	vectorStorePairs ((double *)res, &c, &s);
+}
+
+static inline __attribute__((always_inline)) void
+rectBlock (adder_complex_rect *res, adder_complex_polar *a, int n, int accuracy)
+{
+	adder_complex_polar pad[VECTOR_LENGTH] = {{0}};
+	adder_complex_rect out[VECTOR_LENGTH];
+	int i;
+
+	if (!anglesSafe (a, n)) {
+		for (i = 0; i < n; i++) {
+			res[i] = toRect (a[i]);
+		}
+
+		return;
+	}
+
+	for (i = 0; i + VECTOR_LENGTH <= n; i += VECTOR_LENGTH) {
+		rectGroup (res + i, a + i, accuracy);
+	}
+
+	if (i < n) {
+		memcpy (pad, a + i, (n - i) * sizeof (adder_complex_polar));
+		rectGroup (out, pad, accuracy);
+		memcpy (res + i, out, (n - i) * sizeof (adder_complex_rect));
+	}
+}
+
+static ARRAY_KERNEL void
+rectFullKernel (adder_complex_rect *res, adder_complex_polar *a, int n)
+{
+	rectBlock (res, a, n, COMPLEX_ACCURACY_FULL);
+}
+
+static ARRAY_KERNEL void
+rectFastKernel (adder_complex_rect *res, adder_complex_polar *a, int n)
+{
+	rectBlock (res, a, n, COMPLEX_ACCURACY_FAST);
+}
+
+#else
+
+/* Without vector extensions the remaining kernels call the inline scalar
+ * functions, and both accuracies give the full accuracy of the math library */
+static void
+expKernel (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		res[i] = rectExp (a[i]);
+	}
+}
+
+static void
+argKernel (double *res, adder_complex_rect *a, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		res[i] = rectAngle (a[i]);
+	}
+}
+
+static void
+polarFullKernel (adder_complex_polar *res, adder_complex_rect *a, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		res[i] = toPolar (a[i]);
+	}
+}
+
+static void
+rectFullKernel (adder_complex_rect *res, adder_complex_polar *a, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		res[i] = toRect (a[i]);
+	}
+}
+
+#define polarFastKernel polarFullKernel
+#define rectFastKernel rectFullKernel
+
+#endif
+
+/*********************************
+ * Splitting arrays into blocks  *
+ *********************************/
+static void
+binaryApply (binary_kernel kernel, adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	int k;
+
+	#pragma omp parallel for schedule(static) if (n >= COMPLEX_ARRAY_PARALLEL_SIZE)
+	for (k = 0; k < n; k += COMPLEX_ARRAY_BLOCK) {
+		kernel (res + k, a + k, b + k, n - k < COMPLEX_ARRAY_BLOCK ? n - k : COMPLEX_ARRAY_BLOCK);
+	}
+}
+
+static void
+unaryApply (unary_kernel kernel, adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	int k;
+
+	#pragma omp parallel for schedule(static) if (n >= COMPLEX_ARRAY_PARALLEL_SIZE)
+	for (k = 0; k < n; k += COMPLEX_ARRAY_BLOCK) {
+		kernel (res + k, a + k, n - k < COMPLEX_ARRAY_BLOCK ? n - k : COMPLEX_ARRAY_BLOCK);
+	}
+}
+
+static void
+realApply (real_kernel kernel, double *res, adder_complex_rect *a, int n)
+{
+	int k;
+
+	#pragma omp parallel for schedule(static) if (n >= COMPLEX_ARRAY_PARALLEL_SIZE)
+	for (k = 0; k < n; k += COMPLEX_ARRAY_BLOCK) {
+		kernel (res + k, a + k, n - k < COMPLEX_ARRAY_BLOCK ? n - k : COMPLEX_ARRAY_BLOCK);
+	}
+}
+
+static void
+polarApply (polar_kernel kernel, adder_complex_polar *res, adder_complex_rect *a, int n)
+{
+	int k;
+
+	#pragma omp parallel for schedule(static) if (n >= COMPLEX_ARRAY_PARALLEL_SIZE)
+	for (k = 0; k < n; k += COMPLEX_ARRAY_BLOCK) {
+		kernel (res + k, a + k, n - k < COMPLEX_ARRAY_BLOCK ? n - k : COMPLEX_ARRAY_BLOCK);
+	}
+}
+
+static void
+rectApply (rect_kernel kernel, adder_complex_rect *res, adder_complex_polar *a, int n)
+{
+	int k;
+
+	#pragma omp parallel for schedule(static) if (n >= COMPLEX_ARRAY_PARALLEL_SIZE)
+	for (k = 0; k < n; k += COMPLEX_ARRAY_BLOCK) {
+		kernel (res + k, a + k, n - k < COMPLEX_ARRAY_BLOCK ? n - k : COMPLEX_ARRAY_BLOCK);
+	}
+}
+
+/*********************************
+ * Array functions               *
+ *********************************/
+
+/* res = a + b */
+void
+complexArrayAdd (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	binaryApply (addKernel, res, a, b, n);
+}
+
+/* res = a - b */
+void
+complexArraySub (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	binaryApply (subKernel, res, a, b, n);
+}
+
+/* res = a * b */
+void
+complexArrayMul (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	binaryApply (mulKernel, res, a, b, n);
+}
+
+/* res = a / b */
+void
+complexArrayDiv (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n)
+{
+	binaryApply (divKernel, res, a, b, n);
+}
+
+/* res = conj (a) */
+void
+complexArrayConj (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	unaryApply (conjKernel, res, a, n);
+}
+
+/* res = principal square root of a */
+void
+complexArraySqrt (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	unaryApply (sqrtKernel, res, a, n);
+}
+
+/* res = principal natural log of a */
+void
+complexArrayLog (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	unaryApply (logKernel, res, a, n);
+}
+
+/* res = e^a */
+void
+complexArrayExp (adder_complex_rect *res, adder_complex_rect *a, int n)
+{
+	unaryApply (expKernel, res, a, n);
+}
+
+/* res = |a| */
+void
+complexArrayAbs (double *res, adder_complex_rect *a, int n)
+{
+	realApply (absKernel, res, a, n);
+}
+
+/* res = angle of a in (-pi, pi] */
+void
+complexArrayArg (double *res, adder_complex_rect *a, int n)
+{
+	realApply (argKernel, res, a, n);
+}
+
+/* Convert n rectangular numbers to polar. accuracy is
+ * COMPLEX_ACCURACY_FULL or COMPLEX_ACCURACY_FAST */
+void
+complexArrayToPolar (adder_complex_polar *res, adder_complex_rect *a, int n, int accuracy)
+{
+	polarApply (accuracy == COMPLEX_ACCURACY_FAST ? polarFastKernel : polarFullKernel, res, a, n);
+}
+
+/* Convert n polar numbers to rectangular */
+void
+complexArrayToRect (adder_complex_rect *res, adder_complex_polar *a, int n, int accuracy)
+{
+	rectApply (accuracy == COMPLEX_ACCURACY_FAST ? rectFastKernel : rectFullKernel, res, a, n);
+}
+
+/*********************************
+ * Vector functions              *
+ *********************************/
+static adder_complex_vector *
+binaryVector (binary_kernel kernel, adder_complex_vector *a, adder_complex_vector *b, const char *name)
+{
+	adder_complex_vector *res;
+
+	if (a->size != b->size) {
+		fprintf (stderr, "ERROR:  Vector sizes do not match in function %s.\n", name);
+		return NULL;
+	}
+
+	res = complexVectorInit2 (a->orientation, a->size);
+	if (res == NULL) {
+		return NULL;
+	}
+
+	binaryApply (kernel, res->vect, a->vect, b->vect, a->size);
+
+	return res;
+}
+
+static int
+binaryVectorInPlace (binary_kernel kernel, adder_complex_vector *a, adder_complex_vector *b, const char *name)
+{
+	if (a->size != b->size) {
+		fprintf (stderr, "ERROR:  Vector sizes do not match in function %s.\n", name);
+		return DIMENSION_ERROR;
+	}
+
+	binaryApply (kernel, a->vect, a->vect, b->vect, a->size);
+
+	return 0;
+}
+
+static adder_complex_vector *
+unaryVector (unary_kernel kernel, adder_complex_vector *z)
+{
+	adder_complex_vector *res;
+
+	res = complexVectorInit2 (z->orientation, z->size);
+	if (res == NULL) {
+		return NULL;
+	}
+
+	unaryApply (kernel, res->vect, z->vect, z->size);
+
+	return res;
+}
+
+static adder_vector *
+realVector (real_kernel kernel, adder_complex_vector *z)
+{
+	adder_vector *res;
+
+	res = vectorInit2 (z->orientation, z->size);
+	if (res == NULL) {
+		return NULL;
+	}
+
+	realApply (kernel, res->vect, z->vect, z->size);
+
+	return res;
+}
+
+adder_complex_vector *
+complexVectorAdd (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVector (addKernel, a, b, "complexVectorAdd");
+}
+
+adder_complex_vector *
+complexVectorSub (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVector (subKernel, a, b, "complexVectorSub");
+}
+
+adder_complex_vector *
+complexVectorMul (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVector (mulKernel, a, b, "complexVectorMul");
+}
+
+adder_complex_vector *
+complexVectorDiv (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVector (divKernel, a, b, "complexVectorDiv");
+}
+
+adder_complex_vector *
+complexVectorConj (adder_complex_vector *z)
+{
+	return unaryVector (conjKernel, z);
+}
+
+adder_complex_vector *
+complexVectorSqrt (adder_complex_vector *z)
+{
+	return unaryVector (sqrtKernel, z);
+}
+
+adder_complex_vector *
+complexVectorLog (adder_complex_vector *z)
+{
+	return unaryVector (logKernel, z);
+}
+
+adder_complex_vector *
+complexVectorExp (adder_complex_vector *z)
+{
+	return unaryVector (expKernel, z);
+}
+
+adder_vector *
+complexVectorAbs (adder_complex_vector *z)
+{
+	return realVector (absKernel, z);
+}
+
+adder_vector *
+complexVectorArg (adder_complex_vector *z)
+{
+	return realVector (argKernel, z);
+}
+
+/* a = a + b */
+int
+complexVectorAddInPlace (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVectorInPlace (addKernel, a, b, "complexVectorAddInPlace");
+}
+
+/* a = a - b */
+int
+complexVectorSubInPlace (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVectorInPlace (subKernel, a, b, "complexVectorSubInPlace");
+}
+
+/* a = a * b */
+int
+complexVectorMulInPlace (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVectorInPlace (mulKernel, a, b, "complexVectorMulInPlace");
+}
+
+/* a = a / b */
+int
+complexVectorDivInPlace (adder_complex_vector *a, adder_complex_vector *b)
+{
+	return binaryVectorInPlace (divKernel, a, b, "complexVectorDivInPlace");
+}
+
+void
+complexVectorConjInPlace (adder_complex_vector *z)
+{
+	unaryApply (conjKernel, z->vect, z->vect, z->size);
+}
+
+void
+complexVectorSqrtInPlace (adder_complex_vector *z)
+{
+	unaryApply (sqrtKernel, z->vect, z->vect, z->size);
+}
+
+void
+complexVectorLogInPlace (adder_complex_vector *z)
+{
+	unaryApply (logKernel, z->vect, z->vect, z->size);
+}
+
+void
+complexVectorExpInPlace (adder_complex_vector *z)
+{
+	unaryApply (expKernel, z->vect, z->vect, z->size);
+}
@@ -0,0 +1,71 @@
+/* complex_array.h
+ * Elementwise functions over arrays and vectors of complex numbers.
+ *
+ * The array functions work on n contiguous adder_complex_rect values. The
+ * result may be the same array as an argument, which makes the operation
+ * in place. With GCC and glibc on x86-64, each function is compiled for
+ * AVX-512, AVX2, and generic x86-64, and the version for the running processor
+ * is chosen when the program is loaded. Arrays larger than
+ * COMPLEX_ARRAY_PARALLEL_SIZE are split between threads with OpenMP.
+ *
+ * With GCC, the angles for arg, exp, and conversions between rectangular and
+ * polar form use branch-free atan2 and sin/cos that are vectorized along with
+ * the rest of the loop, instead of calling the math library for each element.
+ * Other compilers call the math library, and both accuracies are then full.
+ * The result of a conversion must not overlap its argument.
+ *
+ * The vector functions check dimensions and either return a new vector or
+ * overwrite their first argument (the InPlace versions). */
+#ifndef ADDER_COMPLEX_ARRAY_H
+#define ADDER_COMPLEX_ARRAY_H
+
+#include "adder_complex.h"
+#include "adder_matrix.h"
+
+/* Arrays at least this long are processed by multiple threads */
+#define COMPLEX_ARRAY_PARALLEL_SIZE 32768
+
+/* Accuracy of conversions between rectangular and polar form */
+enum
+{
+	COMPLEX_ACCURACY_FULL, /* Error of a few units in the last place */
+	COMPLEX_ACCURACY_FAST /* Angle and sin/cos error below 1e-7 */
+};
+
+/* Array functions */
+void complexArrayAdd (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n);
+void complexArraySub (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n);
+void complexArrayMul (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n);
+void complexArrayDiv (adder_complex_rect *res, adder_complex_rect *a, adder_complex_rect *b, int n);
+void complexArrayConj (adder_complex_rect *res, adder_complex_rect *a, int n);
+void complexArraySqrt (adder_complex_rect *res, adder_complex_rect *a, int n);
+void complexArrayLog (adder_complex_rect *res, adder_complex_rect *a, int n);
+void complexArrayExp (adder_complex_rect *res, adder_complex_rect *a, int n);
+void complexArrayAbs (double *res, adder_complex_rect *a, int n);
+void complexArrayArg (double *res, adder_complex_rect *a, int n);
+void complexArrayToPolar (adder_complex_polar *res, adder_complex_rect *a, int n, int accuracy);
+void complexArrayToRect (adder_complex_rect *res, adder_complex_polar *a, int n, int accuracy);
+
+/* Vector functions that return a new vector */
+adder_complex_vector * complexVectorAdd (adder_complex_vector *a, adder_complex_vector *b);
+adder_complex_vector * complexVectorSub (adder_complex_vector *a, adder_complex_vector *b);
+adder_complex_vector * complexVectorMul (adder_complex_vector *a, adder_complex_vector *b);
+adder_complex_vector * complexVectorDiv (adder_complex_vector *a, adder_complex_vector *b);
+adder_complex_vector * complexVectorConj (adder_complex_vector *z);
+adder_complex_vector * complexVectorSqrt (adder_complex_vector *z);
+adder_complex_vector * complexVectorLog (adder_complex_vector *z);
+adder_complex_vector * complexVectorExp (adder_complex_vector *z);
+adder_vector * complexVectorAbs (adder_complex_vector *z);
+adder_vector * complexVectorArg (adder_complex_vector *z);
+
+/* Vector functions that overwrite the first argument */
+int complexVectorAddInPlace (adder_complex_vector *a, adder_complex_vector *b);
+int complexVectorSubInPlace (adder_complex_vector *a, adder_complex_vector *b);
+int complexVectorMulInPlace (adder_complex_vector *a, adder_complex_vector *b);
+int complexVectorDivInPlace (adder_complex_vector *a, adder_complex_vector *b);
+void complexVectorConjInPlace (adder_complex_vector *z);
+void complexVectorSqrtInPlace (adder_complex_vector *z);
+void complexVectorLogInPlace (adder_complex_vector *z);
+void complexVectorExpInPlace (adder_complex_vector *z);
+
+#endif
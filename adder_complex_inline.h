@@ -0,0 +1,218 @@
+/* complex_inline.h
+ * Inline complex arithmetic on values.
+ *
+ * These functions take and return adder_complex_rect and adder_complex_polar
+ * by value, so nothing is allocated and the compiler can keep the numbers in
+ * registers. They are the fastest way to work with single complex numbers in
+ * loops, and the pointer-based functions in complex.h are wrappers around them.
+ * Angles are in radians. The conversions to polar form (toPolar, rectAngle,
+ * and the polar results of polarAdd, polarSub, and polarLog) return angles
+ * in (-pi, pi]. polarMul, polarDiv, polarInv, and polarSqrt add, subtract,
+ * negate, or halve the angles of their arguments without reducing them, so
+ * their results can be outside that interval. */
+#ifndef ADDER_COMPLEX_INLINE_H
+#define ADDER_COMPLEX_INLINE_H
+
+#include <float.h> /* For DBL_MIN */
+#include <math.h>
+#include "adder_complex.h"
+
+/* Construction */
+static inline adder_complex_rect
+makeRect (double real, double imag)
+{
+	adder_complex_rect z;
+
+	z.real = real;
+	z.imag = imag;
+
+	return z;
+}
+
+static inline adder_complex_polar
+makePolar (double mag, double angle)
+{
+	adder_complex_polar z;
+
+	z.mag = mag;
+	z.angle = angle;
+
+	return z;
+}
+
+/* Rectangular arithmetic */
+static inline adder_complex_rect
+rectAdd (adder_complex_rect a, adder_complex_rect b)
+{
+	return makeRect (a.real + b.real, a.imag + b.imag);
+}
+
+static inline adder_complex_rect
+rectSub (adder_complex_rect a, adder_complex_rect b)
+{
+	return makeRect (a.real - b.real, a.imag - b.imag);
+}
+
+static inline adder_complex_rect
+rectMul (adder_complex_rect a, adder_complex_rect b)
+{
+	return makeRect (a.real * b.real - a.imag * b.imag, a.real * b.imag + a.imag * b.real);
+}
+
+static inline adder_complex_rect
+rectDiv (adder_complex_rect a, adder_complex_rect b)
+{
+	double d = b.real * b.real + b.imag * b.imag;
+
+	return makeRect ((a.real * b.real + a.imag * b.imag) / d, (a.imag * b.real - a.real * b.imag) / d);
+}
+
+static inline adder_complex_rect
+rectScale (adder_complex_rect a, double s)
+{
+	return makeRect (s * a.real, s * a.imag);
+}
+
+static inline adder_complex_rect
+rectInv (adder_complex_rect a)
+{
+	double d = a.real * a.real + a.imag * a.imag;
+
+	return makeRect (a.real / d, -a.imag / d);
+}
+
+static inline adder_complex_rect
+rectConj (adder_complex_rect a)
+{
+	return makeRect (a.real, -a.imag);
+}
+
+static inline double
+rectMag (adder_complex_rect a)
+{
+	return hypot (a.real, a.imag);
+}
+
+static inline double
+rectAngle (adder_complex_rect a)
+{
+	return atan2 (a.imag, a.real);
+}
+
+/* Principal square root, calculated without converting to polar form */
+static inline adder_complex_rect
+rectSqrt (adder_complex_rect a)
+{
+	double t;
+
+	if (a.real == 0 && a.imag == 0) {
+		return makeRect (0, a.imag);
+	}
+
+	/* The root of a number with infinite imaginary part is infinite, even
+	 * when the real part is infinite or NaN */
+	if (isinf (a.imag)) {
+		return makeRect (INFINITY, a.imag);
+	}
+
+	/* Subnormal numbers lose precision in the sum below, so they are scaled
+	 * by 2^54 and the root by 2^-27 */
+	if (fabs (a.real) < DBL_MIN && fabs (a.imag) < DBL_MIN) {
+		return rectScale (rectSqrt (rectScale (a, 18014398509481984.0)), 7.450580596923828125e-9);
+	}
+
+	t = sqrt (0.5 * (hypot (a.real, a.imag) + fabs (a.real)));
+	if (a.real >= 0) {
+		return makeRect (t, a.imag / (2 * t));
+	}
+
+	return makeRect (fabs (a.imag) / (2 * t), copysign (t, a.imag));
+}
+
+/* Principal natural log, ln |a| + j arg (a) */
+static inline adder_complex_rect
+rectLog (adder_complex_rect a)
+{
+	return makeRect (log (hypot (a.real, a.imag)), atan2 (a.imag, a.real));
+}
+
+/* e^a = e^real * (cos (imag) + j sin (imag)) */
+static inline adder_complex_rect
+rectExp (adder_complex_rect a)
+{
+	double m = exp (a.real);
+
+	/* A zero imaginary part stays exactly zero when m is infinite or NaN */
+	return makeRect (m * cos (a.imag), a.imag == 0 ? a.imag : m * sin (a.imag));
+}
+
+/* Conversion */
+static inline adder_complex_polar
+toPolar (adder_complex_rect a)
+{
+	return makePolar (hypot (a.real, a.imag), atan2 (a.imag, a.real));
+}
+
+static inline adder_complex_rect
+toRect (adder_complex_polar a)
+{
+	return makeRect (a.mag * cos (a.angle), a.mag * sin (a.angle));
+}
+
+/* Polar arithmetic */
+static inline double
+polarReal (adder_complex_polar a)
+{
+	return a.mag * cos (a.angle);
+}
+
+static inline double
+polarImag (adder_complex_polar a)
+{
+	return a.mag * sin (a.angle);
+}
+
+static inline adder_complex_polar
+polarAdd (adder_complex_polar a, adder_complex_polar b)
+{
+	return toPolar (rectAdd (toRect (a), toRect (b)));
+}
+
+static inline adder_complex_polar
+polarSub (adder_complex_polar a, adder_complex_polar b)
+{
+	return toPolar (rectSub (toRect (a), toRect (b)));
+}
+
+static inline adder_complex_polar
+polarMul (adder_complex_polar a, adder_complex_polar b)
+{
+	return makePolar (a.mag * b.mag, a.angle + b.angle);
+}
+
+static inline adder_complex_polar
+polarDiv (adder_complex_polar a, adder_complex_polar b)
+{
+	return makePolar (a.mag / b.mag, a.angle - b.angle);
+}
+
+static inline adder_complex_polar
+polarInv (adder_complex_polar a)
+{
+	return makePolar (1 / a.mag, -a.angle);
+}
+
+static inline adder_complex_polar
+polarSqrt (adder_complex_polar a)
+{
+	return makePolar (sqrt (a.mag), a.angle / 2);
+}
+
+/* Natural log, ln (mag) + j angle, converted back to polar form */
+static inline adder_complex_polar
+polarLog (adder_complex_polar a)
+{
+	return toPolar (makeRect (log (a.mag), a.angle));
+}
+
+#endif
@@ -0,0 +1,200 @@
+/* complex_interop.h
+ * Zero-copy conversion between Adder complex numbers and the standard
+ * complex types, C99 double _Complex and C++ std::complex<double>.
+ *
+ * All three types are two doubles, the real part followed by the imaginary
+ * part, which both standards guarantee for their types. The layout is checked
+ * when this header is compiled, so arrays of any of them can be used as
+ * arrays of the others through the casts below. The InitCView functions (C)
+ * and InitStdView functions (C++) wrap an existing buffer in a vector or
+ * matrix without copying it. Delete those with deleteComplexVectorView and
+ * deleteComplexMatrixView, which leave the buffer to its owner.
+ *
+ * The compiler may assume that pointers to different types don't point to
+ * the same memory (strict aliasing). In C the casts return pointers to
+ * adder_c_complex, which GCC and Clang are told may alias anything, so they
+ * can be mixed freely with the Adder pointers. Don't read the same elements
+ * through the original double _Complex or std::complex pointer and through
+ * the view in one function after writing through the other, or compile with
+ * -fno-strict-aliasing.
+ *
+ * This header isn't included by complex.h because <complex.h> defines the
+ * macros I and complex, which would clash with names in user code. */
+#ifndef ADDER_COMPLEX_INTEROP_H
+#define ADDER_COMPLEX_INTEROP_H
+
+#ifdef __cplusplus
+
+#include <complex>
+#include <cstddef>
+
+extern "C" {
+#include "adder_complex.h"
+#include "adder_matrix.h"
+}
+
+static_assert (sizeof (adder_complex_rect) == sizeof (std::complex<double>), "adder_complex_rect and std::complex<double> must have the same size");
+static_assert (alignof (adder_complex_rect) == alignof (std::complex<double>), "adder_complex_rect and std::complex<double> must have the same alignment");
+static_assert (offsetof (adder_complex_rect, imag) == sizeof (double), "adder_complex_rect must have no padding");
+
+/* Pointer casts */
+static inline std::complex<double> *
+toStdComplex (adder_complex_rect *z)
+{
+	return reinterpret_cast<std::complex<double> *> (z);
+}
+
+static inline adder_complex_rect *
+fromStdComplex (std::complex<double> *z)
+{
+	return reinterpret_cast<adder_complex_rect *> (z);
+}
+
+/* Value conversions */
+static inline adder_complex_rect
+rectFromStd (std::complex<double> z)
+{
+	adder_complex_rect res;
+
+	res.real = z.real ();
+	res.imag = z.imag ();
+
+	return res;
+}
+
+static inline std::complex<double>
+rectToStd (adder_complex_rect z)
+{
+	return std::complex<double> (z.real, z.imag);
+}
+
+/* Views of std::complex<double> buffers */
+static inline adder_complex_vector *
+complexVectorInitStdView (int orient, int numElements, std::complex<double> *values)
+{
+	return complexVectorInitView (orient, numElements, fromStdComplex (values));
+}
+
+static inline adder_complex_matrix *
+complexMatrixInitStdView (int numRows, int numColumns, std::complex<double> *values)
+{
+	return complexMatrixInitView (numRows, numColumns, fromStdComplex (values));
+}
+
+/* Elements of a vector or matrix as std::complex<double> */
+static inline std::complex<double> *
+complexVectorStdData (adder_complex_vector *z)
+{
+	return toStdComplex (z->vect);
+}
+
+static inline std::complex<double> *
+complexMatrixStdData (adder_complex_matrix *Z)
+{
+	return toStdComplex (Z->mat);
+}
+
+#else
+
+#include <complex.h>
+#include <stddef.h>
+#include "adder_complex.h"
+#include "adder_matrix.h"
+
+#if defined (__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+_Static_assert (sizeof (adder_complex_rect) == sizeof (double _Complex), "adder_complex_rect and double _Complex must have the same size");
+_Static_assert (_Alignof (adder_complex_rect) == _Alignof (double _Complex), "adder_complex_rect and double _Complex must have the same alignment");
+_Static_assert (offsetof (adder_complex_rect, imag) == sizeof (double), "adder_complex_rect must have no padding");
+#else
+/* Before C11 the checks are done with typedefs that have a negative array
+ * size if they fail. The alignment is compared through the offset of the
+ * member after a char */
+struct adder_rect_alignment { char c; adder_complex_rect z; };
+struct adder_c_alignment { char c; double _Complex z; };
+typedef char adder_rect_size_check[sizeof (adder_complex_rect) == sizeof (double _Complex) ? 1 : -1];
+typedef char adder_rect_alignment_check[offsetof (struct adder_rect_alignment, z) == offsetof (struct adder_c_alignment, z) ? 1 : -1];
+typedef char adder_rect_padding_check[offsetof (adder_complex_rect, imag) == sizeof (double) ? 1 : -1];
+#endif
+
+/* double _Complex that may alias adder_complex_rect */
+#if defined (__GNUC__)
+typedef double _Complex adder_c_complex __attribute__ ((may_alias));
+#else
+typedef double _Complex adder_c_complex;
+#endif
+
+/* Pointer casts */
+static inline adder_c_complex *
+toCComplex (adder_complex_rect *z)
+{
+	return (adder_c_complex *)z;
+}
+
+static inline adder_complex_rect *
+fromCComplex (double _Complex *z)
+{
+	return (adder_complex_rect *)z;
+}
+
+/* Value conversions */
+static inline adder_complex_rect
+rectFromC (double _Complex z)
+{
+	adder_complex_rect res;
+
+	res.real = creal (z);
+	res.imag = cimag (z);
+
+	return res;
+}
+
+static inline double _Complex
+rectToC (adder_complex_rect z)
+{
+#ifdef CMPLX
+	return CMPLX (z.real, z.imag);
+#else
+	/* double _Complex has the representation of double[2], and writing
+	 * the parts keeps signed zeros and infinities that z.real + z.imag * I
+	 * would lose */
+	union {
+		double _Complex c;
+		double parts[2];
+	} res;
+
+	res.parts[0] = z.real;
+	res.parts[1] = z.imag;
+
+	return res.c;
+#endif
+}
+
+/* Views of double _Complex buffers */
+static inline adder_complex_vector *
+complexVectorInitCView (int orient, int numElements, double _Complex *values)
+{
+	return complexVectorInitView (orient, numElements, fromCComplex (values));
+}
+
+static inline adder_complex_matrix *
+complexMatrixInitCView (int numRows, int numColumns, double _Complex *values)
+{
+	return complexMatrixInitView (numRows, numColumns, fromCComplex (values));
+}
+
+/* Elements of a vector or matrix as double _Complex */
+static inline adder_c_complex *
+complexVectorCData (adder_complex_vector *z)
+{
+	return toCComplex (z->vect);
+}
+
+static inline adder_c_complex *
+complexMatrixCData (adder_complex_matrix *Z)
+{
+	return toCComplex (Z->mat);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,522 @@
+/* convolve.c
+ * Function definitions for the convolution routines in convolve.h */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy, memmove, and memset */
+#include <math.h> /* For log2 */
+#include "adder_matrix.h"
+#include "adder_fft.h"
+#include "adder_convolve.h"
+
+/* Shortest filter or signal for which the one-shot convolution considers the FFT */
+#define CONVOLVE_DIRECT_LENGTH 64
+
+/* Create a convolver for filter h with taps elements of esize doubles each */
+static adder_convolver *
+convolverCreate (int type, double *h, int taps, int blockSize)
+{
+	const int esize = type == FFT_REAL ? 1 : 2;
+	adder_convolver *c;
+	double cost, bestCost = 0;
+	int size;
+	int err;
+	int n;
+
+	if (taps <= 0) {
+		fprintf (stderr, "ERROR:  Filter must have at least one tap in function convolverInit.\n");
+		return NULL;
+	}
+
+	/* Pick the transform length with the lowest cost per output sample,
+	 * n * log2 (n) / (n - taps + 1), unless a block size is given */
+	if (blockSize > 0) {
+		n = fftGoodSize (blockSize + taps - 1);
+		while (type == FFT_REAL && n % 2 != 0) {
+			n = fftGoodSize (n + 1);
+		}
+	}
+	else {
+		n = 0;
+		for (size = fftGoodSize (2 * taps > 64 ? 2 * taps : 64); size <= 32 * taps || n == 0; size = fftGoodSize (size + 1)) {
+			if (type == FFT_REAL && size % 2 != 0) {
+				continue;
+			}
+
+			cost = size * log2 ((double)size) / (size - taps + 1);
+			if (n == 0 || cost < bestCost) {
+				n = size;
+				bestCost = cost;
+			}
+		}
+	}
+
+	c = calloc (1, sizeof (adder_convolver));
+	if (c == 0x00) {
+		fprintf (stderr, "Failed to create convolver.\n");
+		return NULL;
+	}
+
+	c->type = type;
+	c->taps = taps;
+	c->fftSize = n;
+	c->blockSize = n - taps + 1;
+
+	c->plan = type == FFT_REAL ? fftPlanRealInit (n) : fftPlanInit (n);
+	c->filter = malloc (n * sizeof (adder_complex_rect));
+	c->spectrum = malloc (n * sizeof (adder_complex_rect));
+	c->input = calloc (esize * n, sizeof (double));
+	c->output = malloc (esize * n * sizeof (double));
+	if (c->plan != 0x00) {
+		c->scratch = malloc (fftWorkspaceSize (c->plan) * sizeof (adder_complex_rect));
+	}
+
+	if (c->plan == 0x00 || c->filter == 0x00 || c->spectrum == 0x00 || c->input == 0x00 || c->output == 0x00 || c->scratch == 0x00) {
+		fprintf (stderr, "Failed to create convolver.\n");
+		deleteConvolver (c);
+		return NULL;
+	}
+
+	/* Transform the zero-padded filter, using the output block as space */
+	memset (c->output, 0, esize * n * sizeof (double));
+	memcpy (c->output, h, esize * taps * sizeof (double));
+
+	if (type == FFT_REAL) {
+		err = fftExecuteRealWorkspace (c->plan, c->output, c->filter, c->scratch);
+	}
+	else {
+		err = fftExecuteWorkspace (c->plan, (adder_complex_rect *)c->output, c->filter, FFT_FORWARD, c->scratch);
+	}
+
+	if (err != 0) {
+		fprintf (stderr, "Failed to create convolver.\n");
+		deleteConvolver (c);
+		return NULL;
+	}
+
+	return c;
+}
+
+/* Create a convolver for real signals with the filter h of length taps.
+ * Each block has at least blockSize new samples. If blockSize is zero then
+ * the block size with the lowest cost per sample is used. */
+adder_convolver *
+convolverInit (double *h, int taps, int blockSize)
+{
+	return convolverCreate (FFT_REAL, h, taps, blockSize);
+}
+
+/* Create a convolver for complex signals with the filter h of length taps */
+adder_convolver *
+complexConvolverInit (adder_complex_rect *h, int taps, int blockSize)
+{
+	return convolverCreate (FFT_COMPLEX, (double *)h, taps, blockSize);
+}
+
+/* Delete a convolver */
+void
+deleteConvolver (adder_convolver *c)
+{
+	if (c->plan != 0x00) {
+		deleteFFTPlan (c->plan);
+	}
+
+	free (c->filter);
+	free (c->spectrum);
+	free (c->scratch);
+	free (c->input);
+	free (c->output);
+	free (c);
+}
+
+/* Clear the history of a convolver so the next sample starts a new signal */
+void
+convolverReset (adder_convolver *c)
+{
+	const int esize = c->type == FFT_REAL ? 1 : 2;
+
+	memset (c->input, 0, esize * c->fftSize * sizeof (double));
+	c->fill = 0;
+}
+
+/* Filter the block in c->input. The outputs for the new samples are
+ * stored after the first taps - 1 elements of c->output. Returns the error
+ * of the transforms */
+static int
+filterBlock (adder_convolver *c)
+{
+	const int esize = c->type == FFT_REAL ? 1 : 2;
+	const int size = c->type == FFT_REAL ? c->fftSize / 2 + 1 : c->fftSize;
+	adder_complex_rect *X = c->spectrum;
+	adder_complex_rect *H = c->filter;
+	int err;
+	int k;
+
+	if (c->type == FFT_REAL) {
+		err = fftExecuteRealWorkspace (c->plan, c->input, X, c->scratch);
+	}
+	else {
+		err = fftExecuteWorkspace (c->plan, (adder_complex_rect *)c->input, X, FFT_FORWARD, c->scratch);
+	}
+
+	if (err != 0) {
+		return err;
+	}
+
+	#pragma omp simd
+	for (k = 0; k < size; k++) {
+		double re = X[k].real * H[k].real - X[k].imag * H[k].imag;
+		X[k].imag = X[k].real * H[k].imag + X[k].imag * H[k].real;
+		X[k].real = re;
+	}
+
+	if (c->type == FFT_REAL) {
+		err = fftExecuteRealInverseWorkspace (c->plan, X, c->output, c->scratch);
+	}
+	else {
+		err = fftExecuteWorkspace (c->plan, X, (adder_complex_rect *)c->output, FFT_INVERSE, c->scratch);
+	}
+
+	if (err != 0) {
+		return err;
+	}
+
+	/* Keep the last taps - 1 samples for the next block */
+	memmove (c->input, c->input + esize * c->blockSize, esize * (c->taps - 1) * sizeof (double));
+
+	return 0;
+}
+
+/* Add numSamples samples to the convolver and store the outputs of every
+ * block that is completed. Returns the number of outputs, or -1 if a block
+ * could not be transformed */
+static int
+process (adder_convolver *c, double *in, int numSamples, double *out)
+{
+	const int esize = c->type == FFT_REAL ? 1 : 2;
+	int produced = 0;
+	int k;
+
+	while (numSamples > 0) {
+		k = c->blockSize - c->fill;
+		if (k > numSamples) {
+			k = numSamples;
+		}
+
+		memcpy (c->input + esize * (c->taps - 1 + c->fill), in, esize * k * sizeof (double));
+		in += esize * k;
+		numSamples -= k;
+		c->fill += k;
+
+		if (c->fill == c->blockSize) {
+			if (filterBlock (c) != 0) {
+				return -1;
+			}
+
+			memcpy (out + esize * produced, c->output + esize * (c->taps - 1), esize * c->blockSize * sizeof (double));
+			produced += c->blockSize;
+			c->fill = 0;
+		}
+	}
+
+	return produced;
+}
+
+/* Output the samples waiting in the convolver and the taps - 1 samples
+ * after the end of the signal, then reset it. Returns the number of outputs,
+ * or -1 if a block could not be transformed */
+static int
+flush (adder_convolver *c, double *out)
+{
+	const int esize = c->type == FFT_REAL ? 1 : 2;
+	const int remaining = c->fill + c->taps - 1;
+	int produced = 0;
+	int k;
+
+	while (produced < remaining) {
+		/* The signal is followed by zeros */
+		memset (c->input + esize * (c->taps - 1 + c->fill), 0, esize * (c->blockSize - c->fill) * sizeof (double));
+		if (filterBlock (c) != 0) {
+			convolverReset (c);
+			return -1;
+		}
+
+		k = remaining - produced;
+		if (k > c->blockSize) {
+			k = c->blockSize;
+		}
+
+		memcpy (out + esize * produced, c->output + esize * (c->taps - 1), esize * k * sizeof (double));
+		produced += k;
+		c->fill = 0;
+	}
+
+	convolverReset (c);
+
+	return produced;
+}
+
+/* Filter numSamples samples of a real signal.
+ * Outputs are produced a block at a time, so this returns the number of
+ * outputs stored in out, which needs room for numSamples + blockSize samples.
+ * Output k is sum h[j] * x[k - j], counting from the first sample since the
+ * convolver was created or reset. Returns -1 on error. */
+int
+convolverProcess (adder_convolver *c, double *in, int numSamples, double *out)
+{
+	if (c->type != FFT_REAL) {
+		fprintf (stderr, "ERROR:  Convolver is not for real signals in function convolverProcess.\n");
+		return -1;
+	}
+
+	return process (c, in, numSamples, out);
+}
+
+/* Filter numSamples samples of a complex signal. See convolverProcess */
+int
+complexConvolverProcess (adder_convolver *c, adder_complex_rect *in, int numSamples, adder_complex_rect *out)
+{
+	if (c->type != FFT_COMPLEX) {
+		fprintf (stderr, "ERROR:  Convolver is not for complex signals in function complexConvolverProcess.\n");
+		return -1;
+	}
+
+	return process (c, (double *)in, numSamples, (double *)out);
+}
+
+/* End a real signal. The remaining outputs, including the taps - 1 outputs
+ * past the last sample, are stored in out, which needs room for
+ * blockSize + taps - 1 samples. Returns the number of outputs, or -1 on error */
+int
+convolverFlush (adder_convolver *c, double *out)
+{
+	if (c->type != FFT_REAL) {
+		fprintf (stderr, "ERROR:  Convolver is not for real signals in function convolverFlush.\n");
+		return -1;
+	}
+
+	return flush (c, out);
+}
+
+/* End a complex signal. See convolverFlush */
+int
+complexConvolverFlush (adder_convolver *c, adder_complex_rect *out)
+{
+	if (c->type != FFT_COMPLEX) {
+		fprintf (stderr, "ERROR:  Convolver is not for complex signals in function complexConvolverFlush.\n");
+		return -1;
+	}
+
+	return flush (c, (double *)out);
+}
+
+/* Decide whether convolving signals of lengths na and nb directly is
+ * cheaper than using transforms of length n */
+static int
+useDirect (int na, int nb, int n)
+{
+	if (na <= CONVOLVE_DIRECT_LENGTH || nb <= CONVOLVE_DIRECT_LENGTH) {
+		return 1;
+	}
+
+	return (double)na * nb <= 4.0 * n * log2 ((double)n);
+}
+
+/* Calculate the full convolution of two real vectors, which has
+ * a->size + b->size - 1 elements. If a and b are the coefficients of two
+ * polynomials then this is the coefficients of their product. Short
+ * vectors are convolved directly and long ones using the FFT. */
+adder_vector *
+convolve (adder_vector *a, adder_vector *b)
+{
+	const int na = a->size;
+	const int nb = b->size;
+	const int size = na + nb - 1;
+	adder_fft_plan *plan;
+	adder_complex_rect *A, *B;
+	adder_complex_rect *scratch = 0x00;
+	adder_vector *res;
+	double *pad;
+	double re, sum;
+	int err;
+	int n;
+	int i, k, lo, hi;
+
+	res = vectorInit2 (a->orientation, size);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	n = fftGoodSize (size);
+	while (n % 2 != 0) {
+		n = fftGoodSize (n + 1);
+	}
+
+	if (useDirect (na, nb, n)) {
+		#pragma omp parallel for private(i, lo, hi, sum) if (size > 4096) schedule(static)
+		for (k = 0; k < size; k++) {
+			lo = k - nb + 1 > 0 ? k - nb + 1 : 0;
+			hi = k < na - 1 ? k : na - 1;
+			sum = 0;
+			for (i = lo; i <= hi; i++) {
+				sum += a->vect[i] * b->vect[k - i];
+			}
+
+			res->vect[k] = sum;
+		}
+
+		return res;
+	}
+
+	plan = fftPlanRealInit (n);
+	A = malloc ((n / 2 + 1) * sizeof (adder_complex_rect));
+	B = malloc ((n / 2 + 1) * sizeof (adder_complex_rect));
+	pad = calloc (n, sizeof (double));
+	if (plan != 0x00) {
+		scratch = malloc (fftWorkspaceSize (plan) * sizeof (adder_complex_rect));
+	}
+
+	if (plan == 0x00 || A == 0x00 || B == 0x00 || pad == 0x00 || scratch == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function convolve.\n");
+		if (plan != 0x00) {
+			deleteFFTPlan (plan);
+		}
+		free (A);
+		free (B);
+		free (pad);
+		free (scratch);
+		deleteVector (res);
+		return NULL;
+	}
+
+	memcpy (pad, a->vect, na * sizeof (double));
+	err = fftExecuteRealWorkspace (plan, pad, A, scratch);
+
+	if (err == 0) {
+		memset (pad, 0, n * sizeof (double));
+		memcpy (pad, b->vect, nb * sizeof (double));
+		err = fftExecuteRealWorkspace (plan, pad, B, scratch);
+	}
+
+	if (err == 0) {
+		for (k = 0; k <= n / 2; k++) {
+			re = A[k].real * B[k].real - A[k].imag * B[k].imag;
+			A[k].imag = A[k].real * B[k].imag + A[k].imag * B[k].real;
+			A[k].real = re;
+		}
+
+		err = fftExecuteRealInverseWorkspace (plan, A, pad, scratch);
+	}
+
+	if (err == 0) {
+		memcpy (res->vect, pad, size * sizeof (double));
+	}
+	else {
+		fprintf (stderr, "ERROR:  Failed to transform the signals in function convolve.\n");
+		deleteVector (res);
+		res = NULL;
+	}
+
+	deleteFFTPlan (plan);
+	free (A);
+	free (B);
+	free (pad);
+	free (scratch);
+
+	return res;
+}
+
+/* Calculate the full convolution of two complex vectors. See convolve */
+adder_complex_vector *
+complexConvolve (adder_complex_vector *a, adder_complex_vector *b)
+{
+	const int na = a->size;
+	const int nb = b->size;
+	const int size = na + nb - 1;
+	adder_fft_plan *plan;
+	adder_complex_rect *A, *B;
+	adder_complex_rect *scratch = 0x00;
+	adder_complex_vector *res;
+	double re, sumr, sumi;
+	int err;
+	int n;
+	int i, k, lo, hi;
+
+	res = complexVectorInit2 (a->orientation, size);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	n = fftGoodSize (size);
+
+	if (useDirect (na, nb, n)) {
+		#pragma omp parallel for private(i, lo, hi, sumr, sumi) if (size > 4096) schedule(static)
+		for (k = 0; k < size; k++) {
+			lo = k - nb + 1 > 0 ? k - nb + 1 : 0;
+			hi = k < na - 1 ? k : na - 1;
+			sumr = 0;
+			sumi = 0;
+			for (i = lo; i <= hi; i++) {
+				sumr += a->vect[i].real * b->vect[k - i].real - a->vect[i].imag * b->vect[k - i].imag;
+				sumi += a->vect[i].real * b->vect[k - i].imag + a->vect[i].imag * b->vect[k - i].real;
+			}
+
+			res->vect[k].real = sumr;
+			res->vect[k].imag = sumi;
+		}
+
+		return res;
+	}
+
+	plan = fftPlanInit (n);
+	A = calloc (n, sizeof (adder_complex_rect));
+	B = calloc (n, sizeof (adder_complex_rect));
+	if (plan != 0x00) {
+		scratch = malloc (fftWorkspaceSize (plan) * sizeof (adder_complex_rect));
+	}
+
+	if (plan == 0x00 || A == 0x00 || B == 0x00 || scratch == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function complexConvolve.\n");
+		if (plan != 0x00) {
+			deleteFFTPlan (plan);
+		}
+		free (A);
+		free (B);
+		free (scratch);
+		deleteComplexVector (res);
+		return NULL;
+	}
+
+	memcpy (A, a->vect, na * sizeof (adder_complex_rect));
+	memcpy (B, b->vect, nb * sizeof (adder_complex_rect));
+	err = fftExecuteWorkspace (plan, A, A, FFT_FORWARD, scratch);
+
+	if (err == 0) {
+		err = fftExecuteWorkspace (plan, B, B, FFT_FORWARD, scratch);
+	}
+
+	if (err == 0) {
+		for (k = 0; k < n; k++) {
+			re = A[k].real * B[k].real - A[k].imag * B[k].imag;
+			A[k].imag = A[k].real * B[k].imag + A[k].imag * B[k].real;
+			A[k].real = re;
+		}
+
+		err = fftExecuteWorkspace (plan, A, A, FFT_INVERSE, scratch);
+	}
+
+	if (err == 0) {
+		memcpy (res->vect, A, size * sizeof (adder_complex_rect));
+	}
+	else {
+		fprintf (stderr, "ERROR:  Failed to transform the signals in function complexConvolve.\n");
+		deleteComplexVector (res);
+		res = NULL;
+	}
+
+	deleteFFTPlan (plan);
+	free (A);
+	free (B);
+	free (scratch);
+
+	return res;
+}
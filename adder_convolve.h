@@ -0,0 +1,46 @@
+/* convolve.h
+ * Convolution and FIR filtering using the FFT.
+ *
+ * The streaming convolver uses the overlap-save method. The transform of the
+ * filter is calculated once, and each block of blockSize new samples is
+ * transformed together with the last taps - 1 samples of the previous
+ * blocks, multiplied by the filter, and transformed back. The first taps - 1
+ * outputs of each block wrap around and are discarded. The cost per sample
+ * is O(log (blockSize)) instead of O(taps) for direct convolution. */
+#ifndef ADDER_CONVOLVE_H
+#define ADDER_CONVOLVE_H
+
+#include "adder_matrix.h"
+#include "adder_fft.h"
+
+/* Streaming convolver type definition */
+typedef struct
+{
+	adder_fft_plan *plan; /* Plan for transforms of length fftSize */
+	adder_complex_rect *filter; /* Transform of the zero-padded filter */
+	adder_complex_rect *spectrum; /* Transform of the current block */
+	adder_complex_rect *scratch; /* Workspace for the transforms, so processing doesn't allocate */
+	double *input; /* Last taps - 1 samples followed by the new samples. Complex samples are stored as pairs */
+	double *output; /* Output of the current block */
+	int type; /* FFT_REAL or FFT_COMPLEX */
+	int taps; /* Length of the filter */
+	int fftSize; /* Transform length */
+	int blockSize; /* Number of new samples in each block, fftSize - taps + 1 */
+	int fill; /* Number of new samples waiting in input */
+} adder_convolver;
+
+/* Streaming convolution functions */
+adder_convolver * convolverInit (double *h, int taps, int blockSize);
+adder_convolver * complexConvolverInit (adder_complex_rect *h, int taps, int blockSize);
+void deleteConvolver (adder_convolver *c);
+void convolverReset (adder_convolver *c);
+int convolverProcess (adder_convolver *c, double *in, int numSamples, double *out);
+int complexConvolverProcess (adder_convolver *c, adder_complex_rect *in, int numSamples, adder_complex_rect *out);
+int convolverFlush (adder_convolver *c, double *out);
+int complexConvolverFlush (adder_convolver *c, adder_complex_rect *out);
+
+/* One-shot convolution */
+adder_vector * convolve (adder_vector *a, adder_vector *b);
+adder_complex_vector * complexConvolve (adder_complex_vector *a, adder_complex_vector *b);
+
+#endif
@@ -4,6 +4,7 @@
  * The formulas for the first-order derivatives comes from https://dlmf.nist.gov/3.4#i
  *
  * TODO:  Implement directional derivatives for multi-dimensional functions */
+#include <math.h> /* For fabs and cbrt */
 #include "adder_differentiate.h"
 
 /* Differentiate a function of one variable using the symmetric
@@ -19,8 +20,8 @@ derivSymDiff (adder_function *f, double x, double h)
 	double b;
 	double dx;
 
-	a = f->function (x - h);
-	b = f->function (x + h);
+	a = evaluateFunction (f, x - h);
+	b = evaluateFunction (f, x + h);
 
 	dx = (b - a) / (2 * h);
 
@@ -39,19 +40,19 @@ derivCenter (adder_function *f, double x, double h)
 
 	/* Calculate the values of the Legrange interpolation coefficients */
 	a = (1 - x - 3 * x * x + 2 * x * x * x) / 12.0;
-	a *= f->function (x - 2 * h);
+	a *= evaluateFunction (f, x - 2 * h);
 
 	b = -1 * (4 - 8 * x - 3 * x * x + 4 * x * x * x) / 6.0;
-	b *= f->function (x - h);
+	b *= evaluateFunction (f, x - h);
 
 	c = -1 * (5 * x - 2 * x * x * x) / 2.0;
-	c *= f->function (x);
+	c *= evaluateFunction (f, x);
 
 	d = (4 + 8 * x - 3 * x * x - 4 * x * x * x) / 6.0;
-	d *= f->function (x + h);
+	d *= evaluateFunction (f, x + h);
 
 	e = -1 * (1 + x - 3 * x * x - 2 * x * x * x) / 12.0;
-	e *= f->function (x + 2 * h);
+	e *= evaluateFunction (f, x + 2 * h);
 
 	/* Calculate the derivative by adding the coefficients and dividing by h */
 	dx = (a + b + c + d + e) / h;
@@ -71,19 +72,19 @@ derivForward (adder_function *f, double x, double h)
 
 	/* Calculate the values of the Lagrangian interpolation coefficients */
 	a = (1 - x - 3 * x * x + 2 * x * x * x) / 12.0;
-	a *= f->function (x);
+	a *= evaluateFunction (f, x);
 
 	b = -1 * (4 - 8 * x - 3 * x * x + 4 * x * x * x) / 6.0;
-	b *= f->function (x + h);
+	b *= evaluateFunction (f, x + h);
 
 	c = -1 * (5 * x - 2 * x * x * x) / 2.0;
-	c *= f->function (x + 2 * h);
+	c *= evaluateFunction (f, x + 2 * h);
 
 	d = (4 + 8 * x - 3 * x * x - 4 * x * x * x) / 6.0;
-	d *= f->function (x + 3 * h);
+	d *= evaluateFunction (f, x + 3 * h);
 
 	e = -1 * (1 + x - 3 * x * x - 2 * x * x * x) / 12.0;
-	e *= f->function (x + 4 * h);
+	e *= evaluateFunction (f, x + 4 * h);
 
 	/* Calculate the derivative by adding the coefficients and dividing by h */
 	dx = (a + b + c + d + e) / h;
@@ -103,19 +104,19 @@ derivBackward (adder_function *f, double x, double h)
 
 	/* Calculate the values of the Lagrangian interpolation coefficients */
 	a = (1 - x - 3 * x * x + 2 * x * x * x) / 12.0;
-	a *= f->function (x - 4 * h);
+	a *= evaluateFunction (f, x - 4 * h);
 
 	b = -1 * (4 - 8 * x - 3 * x * x + 4 * x * x * x) / 6.0;
-	b *= f->function (x - 3 * h);
+	b *= evaluateFunction (f, x - 3 * h);
 
 	c = -1 * (5 * x - 2 * x * x * x) / 2.0;
-	c *= f->function (x - 2 * h);
+	c *= evaluateFunction (f, x - 2 * h);
 
 	d = (4 + 8 * x - 3 * x * x - 4 * x * x * x) / 6.0;
-	d *= f->function (x - h);
+	d *= evaluateFunction (f, x - h);
 
 	e = -1 * (1 + x - 3 * x * x - 2 * x * x * x) / 12.0;
-	e *= f->function (x);
+	e *= evaluateFunction (f, x);
 
 	/* Calculate the derivative by adding the coefficients and dividing by h */
 	dx = (a + b + c + d + e) / h;
@@ -133,11 +134,75 @@ derivSecondSymDiff (adder_function *f, double x, double h)
 	double fx;
 	double ddf;
 	
-	fPositive = f->function (x + h);
-	fNegative = f->function (x - h);
-	fx = f->function (x);
+	fPositive = evaluateFunction (f, x + h);
+	fNegative = evaluateFunction (f, x - h);
+	fx = evaluateFunction (f, x);
 	
 	ddf = (fPositive + fNegative - 2 * fx) / (h * h);
 	
 	return ddf;
 }
+
+/* Derivatives with respect to model parameters */
+
+/* Calculate the Jacobian of a model function with respect to its parameters
+ * f is the model function
+ * x is an array of the m points at which the model is evaluated
+ * params is an array of the n parameters of the model
+ * h is the relative step size. If it isn't positive then a step size of
+ * cbrt (DBL_EPSILON), which is optimal for central differences, is used
+ * J is an m x n array, stored by rows, that holds the Jacobian on return
+ *
+ * If the model has an analytic gradient it is used for each row of J.
+ * Otherwise each column is calculated using the symmetric difference quotient
+ * in the parameter. The columns are calculated in parallel, so the model
+ * function must be safe to call from multiple threads. */
+void
+derivModelJacobian (adder_model_function *f, double *x, int m, double *params, int n, double h, double *J)
+{
+	int i;
+
+	/* Use the analytic gradient if there is one */
+	if (f->gradient != 0x00) {
+		#pragma omp parallel for schedule(static)
+		for (i = 0; i < m; i++) {
+			f->gradient (x[i], params, &J[i * n], f->data);
+		}
+
+		return;
+	}
+
+	if (h <= 0) {
+		h = cbrt (__DBL_EPSILON__);
+	}
+
+	#pragma omp parallel
+	{
+		double p[n]; /* Each thread perturbs its own copy of the parameters */
+		double step;
+		double fPositive, fNegative;
+		int j, k;
+
+		for (k = 0; k < n; k++) {
+			p[k] = params[k];
+		}
+
+		#pragma omp for schedule(dynamic, 1)
+		for (j = 0; j < n; j++) {
+			/* Scale the step by the size of the parameter */
+			step = h * (fabs (params[j]) > 1 ? fabs (params[j]) : 1);
+
+			for (k = 0; k < m; k++) {
+				p[j] = params[j] + step;
+				fPositive = f->function (x[k], p, f->data);
+
+				p[j] = params[j] - step;
+				fNegative = f->function (x[k], p, f->data);
+
+				J[k * n + j] = (fPositive - fNegative) / (2 * step);
+			}
+
+			p[j] = params[j];
+		}
+	}
+}
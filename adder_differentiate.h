@@ -15,4 +15,7 @@ double derivBackward (adder_function *f, double x, double h);
 /* Second order methods */
 double derivSecondSymDiff (adder_function *f, double x, double h);
 
+/* Derivatives with respect to model parameters */
+void derivModelJacobian (adder_model_function *f, double *x, int m, double *params, int n, double h, double *J);
+
 #endif
@@ -0,0 +1,396 @@
+/* expm.c
+ * Function definitions for the matrix exponential routines in expm.h */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy */
+#include <math.h> /* For fabs, exp, ceil, and log2 */
+#include <cblas.h>
+#include <lapacke.h>
+#include "adder_matrix.h"
+#include "adder_linalg.h" /* For matrixNorm1 */
+#include "adder_expm.h"
+
+/* Largest 1-norm of t * A for which each Pade approximant is accurate
+ * to double precision. These are for degrees 3, 5, 7, 9, and 13. */
+static const double theta[5] = {1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1, 2.097847961257068e0, 5.371920351148152e0};
+static const int degrees[5] = {3, 5, 7, 9, 13};
+
+/* Coefficients of the Pade approximants */
+static const double b3[4] = {120.0, 60.0, 12.0, 1.0};
+static const double b5[6] = {30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0};
+static const double b7[8] = {17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 1.0};
+static const double b9[10] = {17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0, 2162160.0, 110880.0, 3960.0, 90.0, 1.0};
+static const double b13[14] = {64764752532480000.0, 32382376266240000.0, 7771770303897600.0, 1187353796428800.0,
+			       129060195264000.0, 10559470521600.0, 670442572800.0, 33522128640.0,
+			       1323241920.0, 40840800.0, 960960.0, 16380.0, 182.0, 1.0};
+
+/* Create a workspace for calculating the exponential of n x n matrices */
+adder_expm_workspace *
+expmWorkspaceInit (int n)
+{
+	adder_expm_workspace *w;
+
+	w = malloc (sizeof (adder_expm_workspace));
+	if (w == 0x00) {
+		fprintf (stderr, "Failed to create matrix exponential workspace.\n");
+		return NULL;
+	}
+
+	/* Eight n x n matrices are needed */
+	w->work = malloc (8 * n * n * sizeof (double));
+	if (w->work == 0x00) {
+		fprintf (stderr, "Failed to create matrix exponential workspace.\n");
+		free (w);
+		return NULL;
+	}
+
+	w->ipvt = malloc (n * sizeof (int));
+	if (w->ipvt == 0x00) {
+		fprintf (stderr, "Failed to create matrix exponential workspace.\n");
+		free (w->work);
+		free (w);
+		return NULL;
+	}
+
+	w->n = n;
+
+	return w;
+}
+
+/* Delete a matrix exponential workspace */
+void
+deleteExpmWorkspace (adder_expm_workspace *w)
+{
+	free (w->work);
+	free (w->ipvt);
+	free (w);
+}
+
+/* Multiply two n x n matrices, res = A * B */
+static void
+multiply (int n, double *A, double *B, double *res)
+{
+	cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, 1.0, A, n, B, n, 0.0, res, n);
+}
+
+/* Calculate exp(t * A) using the workspace w and store it in res.
+ * A and res must both be w->n x w->n and A is not overwritten.
+ * The only memory used is in w, so this is suitable for calculating
+ * many exponentials of the same size, such as in an ODE propagator. */
+int
+expmWorkspace (adder_expm_workspace *w, adder_matrix *A, double t, adder_matrix *res)
+{
+	const int n = w->n;
+	const int nn = n * n;
+	double *X = w->work; /* t * A scaled by 2^-s */
+	double *A2 = X + nn;
+	double *A4 = A2 + nn;
+	double *A6 = A4 + nn;
+	double *A8 = A6 + nn;
+	double *U = A8 + nn;
+	double *V = U + nn;
+	double *T = V + nn;
+	double *powers[5] = {0x00, A2, A4, A6, A8};
+	double *cur, *other, *swap;
+	const double *b;
+	double norm;
+	double scale;
+	int degree;
+	int s = 0;
+	int i, k;
+	lapack_int err;
+
+	/* Check the dimensions */
+	if (A->rows != n || A->columns != n || res->rows != n || res->columns != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function expmWorkspace.\n");
+		return DIMENSION_ERROR;
+	}
+
+	norm = fabs (t) * matrixNorm1 (A);
+
+	/* Pick the lowest degree approximant that is accurate enough.
+	 * If none are then scale the matrix so degree 13 is */
+	for (k = 0; k < 4; k++) {
+		if (norm <= theta[k]) {
+			break;
+		}
+	}
+
+	degree = degrees[k];
+
+	if (k == 4) {
+		s = (int)ceil (log2 (norm / theta[4]));
+		if (s < 0) {
+			s = 0;
+		}
+	}
+
+	scale = t * ldexp (1.0, -s);
+
+	for (i = 0; i < nn; i++) {
+		X[i] = scale * A->mat[i];
+	}
+
+	/* Calculate the even powers of X that are needed */
+	multiply (n, X, X, A2);
+	if (degree >= 5) {
+		multiply (n, A2, A2, A4);
+	}
+
+	if (degree >= 7) {
+		multiply (n, A2, A4, A6);
+	}
+
+	if (degree == 9) {
+		multiply (n, A4, A4, A8);
+	}
+
+	if (degree == 13) {
+		b = b13;
+
+		/* U = X * [A6 * (b13 * A6 + b11 * A4 + b9 * A2) + b7 * A6 + b5 * A4 + b3 * A2 + b1 * I] */
+		for (i = 0; i < nn; i++) {
+			T[i] = b[13] * A6[i] + b[11] * A4[i] + b[9] * A2[i];
+		}
+
+		multiply (n, A6, T, U);
+
+		for (i = 0; i < nn; i++) {
+			U[i] += b[7] * A6[i] + b[5] * A4[i] + b[3] * A2[i];
+		}
+
+		for (i = 0; i < n; i++) {
+			U[i * n + i] += b[1];
+		}
+
+		multiply (n, X, U, T);
+
+		/* V = A6 * (b12 * A6 + b10 * A4 + b8 * A2) + b6 * A6 + b4 * A4 + b2 * A2 + b0 * I */
+		for (i = 0; i < nn; i++) {
+			A8[i] = b[12] * A6[i] + b[10] * A4[i] + b[8] * A2[i];
+		}
+
+		multiply (n, A6, A8, V);
+
+		for (i = 0; i < nn; i++) {
+			V[i] += b[6] * A6[i] + b[4] * A4[i] + b[2] * A2[i];
+		}
+
+		for (i = 0; i < n; i++) {
+			V[i * n + i] += b[0];
+		}
+	}
+
+	else {
+		if (degree == 3) {
+			b = b3;
+		}
+		else if (degree == 5) {
+			b = b5;
+		}
+		else if (degree == 7) {
+			b = b7;
+		}
+		else {
+			b = b9;
+		}
+
+		/* U = X * (sum of b[2k + 1] * X^2k) and V = sum of b[2k] * X^2k */
+		for (i = 0; i < nn; i++) {
+			U[i] = 0;
+			V[i] = 0;
+		}
+
+		for (i = 0; i < n; i++) {
+			U[i * n + i] = b[1];
+			V[i * n + i] = b[0];
+		}
+
+		for (k = 1; 2 * k <= degree; k++) {
+			for (i = 0; i < nn; i++) {
+				U[i] += b[2 * k + 1] * powers[k][i];
+				V[i] += b[2 * k] * powers[k][i];
+			}
+		}
+
+		multiply (n, X, U, T);
+	}
+
+	/* T now holds U. The approximant is the solution of
+	 * (V - U) * res = (V + U) */
+	for (i = 0; i < nn; i++) {
+		res->mat[i] = V[i] + T[i];
+		V[i] -= T[i];
+	}
+
+	err = LAPACKE_dgesv (LAPACK_ROW_MAJOR, n, n, V, n, w->ipvt, res->mat, n);
+	if (err < 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		return ARGUMENT_ERROR;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "ERROR:  Pade denominator is singular in function expmWorkspace.\n");
+		return SINGULAR_MATRIX;
+	}
+
+	/* Undo the scaling by squaring the result s times */
+	cur = res->mat;
+	other = T;
+	for (i = 0; i < s; i++) {
+		multiply (n, cur, cur, other);
+		swap = cur;
+		cur = other;
+		other = swap;
+	}
+
+	if (cur != res->mat) {
+		memcpy (res->mat, cur, nn * sizeof (double));
+	}
+
+	return 0;
+}
+
+/* Calculate the matrix exponential exp(t * A) of a square matrix */
+adder_matrix *
+expm (adder_matrix *A, double t)
+{
+	adder_expm_workspace *w;
+	adder_matrix *res;
+
+	/* The matrix has to be square */
+	if (A->rows != A->columns) {
+		fprintf (stderr, "Dimension error:  Matrix not square.\n");
+		return NULL;
+	}
+
+	w = expmWorkspaceInit (A->rows);
+	if (w == 0x00) {
+		return NULL;
+	}
+
+	res = matrixInit2 (A->rows, A->columns);
+	if (res == 0x00) {
+		deleteExpmWorkspace (w);
+		return NULL;
+	}
+
+	if (expmWorkspace (w, A, t, res) != 0) {
+		deleteExpmWorkspace (w);
+		deleteMatrix (res);
+		return NULL;
+	}
+
+	deleteExpmWorkspace (w);
+
+	return res;
+}
+
+/* Calculate exp(t * A) * v without forming the matrix exponential.
+ * The interval is split into s steps so that the 1-norm of each step
+ * is at most one, and on each step the Taylor series is summed until the
+ * terms are negligible. A is shifted by the mean of its eigenvalues
+ * (trace (A) / n) first, which reduces the norm and so the number of steps.
+ * Only matrix-vector products with A are used, so the cost is O(n^2) per term. */
+adder_vector *
+expmv (adder_matrix *A, double t, adder_vector *v)
+{
+	const int n = A->rows;
+	const double tol = __DBL_EPSILON__ / 2;
+	adder_vector *res;
+	double *term;
+	double *next;
+	double *swap;
+	double mu = 0;
+	double norm = 0;
+	double colSum;
+	double h;
+	double termNorm, prevNorm, fNorm;
+	double eta;
+	int s;
+	int i, j, k;
+	int step;
+
+	/* Check the dimensions */
+	if (A->rows != A->columns) {
+		fprintf (stderr, "Dimension error:  Matrix not square.\n");
+		return NULL;
+	}
+
+	if (v->orientation == ROW_VECTOR || v->size != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function expmv.\n");
+		return NULL;
+	}
+
+	res = vectorInit (COLUMN_VECTOR, n, v->vect);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	term = malloc (n * sizeof (double));
+	next = malloc (n * sizeof (double));
+	if (term == 0x00 || next == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function expmv.\n");
+		free (term);
+		free (next);
+		deleteVector (res);
+		return NULL;
+	}
+
+	/* Shift A by the mean of its eigenvalues */
+	for (i = 0; i < n; i++) {
+		mu += A->mat[i * n + i];
+	}
+
+	mu /= n;
+
+	/* Calculate the 1-norm of t * (A - mu * I) to pick the number of steps */
+	for (j = 0; j < n; j++) {
+		colSum = 0;
+		for (i = 0; i < n; i++) {
+			colSum += fabs (A->mat[i * n + j] - (i == j ? mu : 0));
+		}
+
+		if (colSum > norm) {
+			norm = colSum;
+		}
+	}
+
+	norm *= fabs (t);
+	s = norm > 1 ? (int)ceil (norm) : 1;
+	h = t / s;
+	eta = exp (mu * h);
+
+	for (step = 0; step < s; step++) {
+		memcpy (term, res->vect, n * sizeof (double));
+		fNorm = 0;
+		prevNorm = 0;
+
+		for (k = 1; k <= 60; k++) {
+			/* next = h * (A - mu * I) * term / k */
+			cblas_dgemv (CblasRowMajor, CblasNoTrans, n, n, h / k, A->mat, n, term, 1, 0.0, next, 1);
+			cblas_daxpy (n, -mu * h / k, term, 1, next, 1);
+
+			cblas_daxpy (n, 1.0, next, 1, res->vect, 1);
+
+			swap = term;
+			term = next;
+			next = swap;
+
+			/* Stop when two consecutive terms are negligible */
+			termNorm = fabs (term[cblas_idamax (n, term, 1)]);
+			fNorm = fabs (res->vect[cblas_idamax (n, res->vect, 1)]);
+			if (termNorm + prevNorm <= tol * fNorm) {
+				break;
+			}
+
+			prevNorm = termNorm;
+		}
+
+		cblas_dscal (n, eta, res->vect, 1);
+	}
+
+	free (term);
+	free (next);
+
+	return res;
+}
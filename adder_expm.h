@@ -0,0 +1,34 @@
+/* expm.h
+ * Matrix exponential routines.
+ *
+ * exp(t * A) is calculated using the scaling and squaring method with Pade
+ * approximants described by Higham in "The Scaling and Squaring Method for
+ * the Matrix Exponential Revisited" (https://doi.org/10.1137/04061101X).
+ * The action exp(t * A) * v can also be calculated without forming the
+ * matrix exponential, which only needs matrix-vector products. */
+#ifndef ADDER_EXPM_H
+#define ADDER_EXPM_H
+
+#include "adder_matrix.h"
+
+/* Workspace for calculating matrix exponentials of a fixed size.
+ * Creating one and reusing it avoids allocating memory on every call. */
+typedef struct
+{
+	double *work; /* Holds the scaled matrix, its powers, and the Pade numerator and denominator */
+	int *ipvt; /* Pivots for the LU solve */
+	int n; /* Number of rows and columns of the matrices */
+} adder_expm_workspace;
+
+/* Workspace functions */
+adder_expm_workspace * expmWorkspaceInit (int n);
+void deleteExpmWorkspace (adder_expm_workspace *w);
+
+/* Matrix exponential */
+adder_matrix * expm (adder_matrix *A, double t);
+int expmWorkspace (adder_expm_workspace *w, adder_matrix *A, double t, adder_matrix *res);
+
+/* Action of the matrix exponential on a vector */
+adder_vector * expmv (adder_matrix *A, double t, adder_vector *v);
+
+#endif
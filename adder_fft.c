@@ -0,0 +1,928 @@
+/* fft.c
+ * Function definitions for the fast Fourier transforms in fft.h */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy */
+#include <math.h> /* For sin and cos */
+#include "adder_matrix.h"
+#include "adder_fft.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Number of columns transformed together in two-dimensional transforms */
+#define FFT_COLUMN_BLOCK 8
+
+/* Return exp(-2 * pi * i * k / n) with k reduced so large arguments stay accurate */
+static adder_complex_rect
+twiddle (long int k, long int n)
+{
+	adder_complex_rect w;
+	double angle;
+
+	k %= n;
+	angle = -2 * M_PI * (double)k / (double)n;
+	w.real = cos (angle);
+	w.imag = sin (angle);
+
+	return w;
+}
+
+/* Return the smallest length at least n whose only prime factors are 2, 3, and 5.
+ * Transforms of these lengths don't need Bluestein's algorithm, so this is
+ * the length to pad to when the exact length doesn't matter. */
+int
+fftGoodSize (int n)
+{
+	int m, k;
+
+	for (m = n; ; m++) {
+		k = m;
+		while (k % 2 == 0) {
+			k /= 2;
+		}
+
+		while (k % 3 == 0) {
+			k /= 3;
+		}
+
+		while (k % 5 == 0) {
+			k /= 5;
+		}
+
+		if (k == 1) {
+			return m;
+		}
+	}
+}
+
+/* Radix 2, 3, 4, and 5 butterflies of the values in re and im.
+ * sign is the sign of the exponent, -1 for forward transforms */
+static inline __attribute__((always_inline)) void
+butterfly (int radix, double *re, double *im, int sign)
+{
+	const double s3 = 0.86602540378443864676; /* sin (2 * pi / 3) */
+	const double c51 = 0.30901699437494742410; /* cos (2 * pi / 5) */
+	const double c52 = -0.80901699437494742410; /* cos (4 * pi / 5) */
+	const double s51 = 0.95105651629515357212; /* sin (2 * pi / 5) */
+	const double s52 = 0.58778525229247312917; /* sin (4 * pi / 5) */
+	double t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i, t4r, t4i;
+	double b1r, b1i, b2r, b2i, d1r, d1i, d2r, d2i;
+
+	switch (radix) {
+	case 2:
+		t0r = re[0] - re[1];
+		t0i = im[0] - im[1];
+		re[0] += re[1];
+		im[0] += im[1];
+		re[1] = t0r;
+		im[1] = t0i;
+		break;
+
+	case 3:
+		t1r = re[1] + re[2];
+		t1i = im[1] + im[2];
+
+		/* (a1 - a2) * i * sign * sin (2 * pi / 3) */
+		t2r = -sign * s3 * (im[1] - im[2]);
+		t2i = sign * s3 * (re[1] - re[2]);
+
+		t0r = re[0] - 0.5 * t1r;
+		t0i = im[0] - 0.5 * t1i;
+		re[0] += t1r;
+		im[0] += t1i;
+		re[1] = t0r + t2r;
+		im[1] = t0i + t2i;
+		re[2] = t0r - t2r;
+		im[2] = t0i - t2i;
+		break;
+
+	case 4:
+		t0r = re[0] + re[2];
+		t0i = im[0] + im[2];
+		t1r = re[0] - re[2];
+		t1i = im[0] - im[2];
+		t2r = re[1] + re[3];
+		t2i = im[1] + im[3];
+
+		/* (a1 - a3) * i * sign */
+		t3r = -sign * (im[1] - im[3]);
+		t3i = sign * (re[1] - re[3]);
+
+		re[0] = t0r + t2r;
+		im[0] = t0i + t2i;
+		re[2] = t0r - t2r;
+		im[2] = t0i - t2i;
+		re[1] = t1r + t3r;
+		im[1] = t1i + t3i;
+		re[3] = t1r - t3r;
+		im[3] = t1i - t3i;
+		break;
+
+	case 5:
+		t1r = re[1] + re[4];
+		t1i = im[1] + im[4];
+		t2r = re[2] + re[3];
+		t2i = im[2] + im[3];
+		t3r = re[1] - re[4];
+		t3i = im[1] - im[4];
+		t4r = re[2] - re[3];
+		t4i = im[2] - im[3];
+
+		b1r = re[0] + c51 * t1r + c52 * t2r;
+		b1i = im[0] + c51 * t1i + c52 * t2i;
+		b2r = re[0] + c52 * t1r + c51 * t2r;
+		b2i = im[0] + c52 * t1i + c51 * t2i;
+
+		/* i * sign * (s51 * t3 + s52 * t4) and i * sign * (s52 * t3 - s51 * t4) */
+		d1r = -sign * (s51 * t3i + s52 * t4i);
+		d1i = sign * (s51 * t3r + s52 * t4r);
+		d2r = -sign * (s52 * t3i - s51 * t4i);
+		d2i = sign * (s52 * t3r - s51 * t4r);
+
+		re[0] += t1r + t2r;
+		im[0] += t1i + t2i;
+		re[1] = b1r + d1r;
+		im[1] = b1i + d1i;
+		re[4] = b1r - d1r;
+		im[4] = b1i - d1i;
+		re[2] = b2r + d2r;
+		im[2] = b2i + d2i;
+		re[3] = b2r - d2r;
+		im[3] = b2i - d2i;
+		break;
+	}
+}
+
+/* One Stockham stage of a length n transform from x to y.
+ * Ns is the product of the radices of the previous stages. Element
+ * j + r * n / radix of x, with j = k * Ns + i, is multiplied by twiddle
+ * factor r * i / (Ns * radix), and the butterfly results go to element
+ * k * Ns * radix + i + r * Ns of y. Both the input and the output are
+ * contiguous in i, which is the vectorized loop. */
+static inline __attribute__((always_inline)) void
+radixStage (int n, int radix, int Ns, const adder_complex_rect *tw, const adder_complex_rect *x, adder_complex_rect *y, int sign)
+{
+	const int stride = n / radix;
+	const int blocks = stride / Ns;
+	int i, k;
+
+	/* The first stage has no twiddle factors and only one element per block */
+	if (Ns == 1) {
+		#pragma omp simd
+		for (k = 0; k < blocks; k++) {
+			double re[5], im[5];
+			int r;
+
+			for (r = 0; r < radix; r++) {
+				re[r] = x[k + r * stride].real;
+				im[r] = x[k + r * stride].imag;
+			}
+
+			butterfly (radix, re, im, sign);
+
+			for (r = 0; r < radix; r++) {
+				y[k * radix + r].real = re[r];
+				y[k * radix + r].imag = im[r];
+			}
+		}
+
+		return;
+	}
+
+	for (k = 0; k < blocks; k++) {
+		const adder_complex_rect *in = x + k * Ns;
+		adder_complex_rect *out = y + k * Ns * radix;
+
+		#pragma omp simd
+		for (i = 0; i < Ns; i++) {
+			double re[5], im[5];
+			double ar, ai, wr, wi;
+			int r;
+
+			re[0] = in[i].real;
+			im[0] = in[i].imag;
+
+			for (r = 1; r < radix; r++) {
+				/* The inverse transform uses the conjugate twiddle factors */
+				wr = tw[(r - 1) * Ns + i].real;
+				wi = -sign * tw[(r - 1) * Ns + i].imag;
+				ar = in[i + r * stride].real;
+				ai = in[i + r * stride].imag;
+				re[r] = ar * wr - ai * wi;
+				im[r] = ar * wi + ai * wr;
+			}
+
+			butterfly (radix, re, im, sign);
+
+			for (r = 0; r < radix; r++) {
+				out[i + r * Ns].real = re[r];
+				out[i + r * Ns].imag = im[r];
+			}
+		}
+	}
+}
+
+/* Run one stage with the radix known at compile time so the butterfly is inlined */
+static void
+stage (int n, int radix, int Ns, const adder_complex_rect *tw, const adder_complex_rect *x, adder_complex_rect *y, int sign)
+{
+	switch (radix) {
+	case 2:
+		radixStage (n, 2, Ns, tw, x, y, sign);
+		break;
+	case 3:
+		radixStage (n, 3, Ns, tw, x, y, sign);
+		break;
+	case 4:
+		radixStage (n, 4, Ns, tw, x, y, sign);
+		break;
+	case 5:
+		radixStage (n, 5, Ns, tw, x, y, sign);
+		break;
+	}
+}
+
+/* Transform x in place using a complex plan without scaling.
+ * scratch must have room for plan->scratchSize elements */
+static void
+transform (adder_fft_plan *plan, adder_complex_rect *x, adder_complex_rect *scratch, int sign)
+{
+	const int n = plan->n;
+	adder_complex_rect *src, *dst, *swap;
+	adder_complex_rect *a, *w, *B;
+	int Ns = 1;
+	int s, j;
+
+	/* Bluestein's algorithm. Since j * k = (j^2 + k^2 - (k - j)^2) / 2,
+	 * X[k] = w[k] * sum (x[j] * w[j]) * conj (w[k - j]) with w[k] = exp(-i * pi * k^2 / n),
+	 * which is a convolution that is done with transforms of the smooth length m */
+	if (plan->chirp != 0x00) {
+		a = scratch;
+		w = plan->chirp;
+		B = plan->chirpSpectrum + (sign == FFT_FORWARD ? 0 : plan->m);
+
+		for (j = 0; j < n; j++) {
+			a[j].real = x[j].real * w[j].real + sign * x[j].imag * w[j].imag;
+			a[j].imag = x[j].imag * w[j].real - sign * x[j].real * w[j].imag;
+		}
+
+		for (j = n; j < plan->m; j++) {
+			a[j].real = 0;
+			a[j].imag = 0;
+		}
+
+		transform (plan->sub, a, scratch + plan->m, FFT_FORWARD);
+
+		/* The 1 / m scaling of the inverse transform is part of B */
+		#pragma omp simd
+		for (j = 0; j < plan->m; j++) {
+			double re = a[j].real * B[j].real - a[j].imag * B[j].imag;
+			double im = a[j].real * B[j].imag + a[j].imag * B[j].real;
+			a[j].real = re;
+			a[j].imag = im;
+		}
+
+		transform (plan->sub, a, scratch + plan->m, FFT_INVERSE);
+
+		for (j = 0; j < n; j++) {
+			x[j].real = a[j].real * w[j].real + sign * a[j].imag * w[j].imag;
+			x[j].imag = a[j].imag * w[j].real - sign * a[j].real * w[j].imag;
+		}
+
+		return;
+	}
+
+	/* Stockham stages alternate between x and scratch */
+	src = x;
+	dst = scratch;
+	for (s = 0; s < plan->numStages; s++) {
+		stage (n, plan->radices[s], Ns, plan->twiddles + plan->offsets[s], src, dst, sign);
+		Ns *= plan->radices[s];
+
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != x) {
+		memcpy (x, src, n * sizeof (adder_complex_rect));
+	}
+}
+
+/* Create a plan for complex transforms of length n */
+adder_fft_plan *
+fftPlanInit (int n)
+{
+	adder_fft_plan *plan;
+	adder_complex_rect *b;
+	adder_complex_rect *scratch = 0x00;
+	long int k2;
+	int remaining;
+	int numTwiddles = 0;
+	int Ns;
+	int s, r, i, j;
+
+	if (n <= 0) {
+		fprintf (stderr, "ERROR:  Transform length must be positive in function fftPlanInit.\n");
+		return NULL;
+	}
+
+	plan = calloc (1, sizeof (adder_fft_plan));
+	if (plan == 0x00) {
+		fprintf (stderr, "Failed to create FFT plan.\n");
+		return NULL;
+	}
+
+	plan->n = n;
+	plan->type = FFT_COMPLEX;
+
+	/* Factor n, using radix 4 where possible since it needs the fewest operations */
+	remaining = n;
+	while (remaining % 4 == 0) {
+		plan->radices[plan->numStages++] = 4;
+		remaining /= 4;
+	}
+
+	for (r = 2; r <= 5; r++) {
+		while (r != 4 && remaining % r == 0) {
+			plan->radices[plan->numStages++] = r;
+			remaining /= r;
+		}
+	}
+
+	/* Lengths with other prime factors use Bluestein's algorithm */
+	if (remaining != 1) {
+		plan->numStages = 0;
+		plan->m = fftGoodSize (2 * n - 1);
+
+		plan->sub = fftPlanInit (plan->m);
+		plan->chirp = malloc (n * sizeof (adder_complex_rect));
+		plan->chirpSpectrum = calloc (2 * plan->m, sizeof (adder_complex_rect));
+		scratch = malloc (plan->m * sizeof (adder_complex_rect));
+		if (plan->sub == 0x00 || plan->chirp == 0x00 || plan->chirpSpectrum == 0x00 || scratch == 0x00) {
+			fprintf (stderr, "Failed to create FFT plan.\n");
+			free (scratch);
+			deleteFFTPlan (plan);
+			return NULL;
+		}
+
+		/* k^2 is reduced mod 2n so the angle stays accurate */
+		for (j = 0; j < n; j++) {
+			k2 = ((long int)j * j) % (2 * n);
+			plan->chirp[j] = twiddle (k2, 2 * n);
+		}
+
+		/* The filters conj (w) for forward and w for inverse transforms,
+		 * wrapped around for negative indices and scaled by 1 / m */
+		for (s = 0; s < 2; s++) {
+			b = plan->chirpSpectrum + s * plan->m;
+			for (j = 0; j < n; j++) {
+				b[j].real = plan->chirp[j].real / plan->m;
+				b[j].imag = (s == 0 ? -1 : 1) * plan->chirp[j].imag / plan->m;
+				if (j > 0) {
+					b[plan->m - j] = b[j];
+				}
+			}
+
+			transform (plan->sub, b, scratch, FFT_FORWARD);
+		}
+
+		free (scratch);
+
+		plan->scratchSize = 2 * plan->m;
+
+		return plan;
+	}
+
+	/* Twiddle factors exp(-2 * pi * i * r * i / (Ns * radix)) for each stage */
+	Ns = 1;
+	for (s = 0; s < plan->numStages; s++) {
+		plan->offsets[s] = numTwiddles;
+		numTwiddles += (plan->radices[s] - 1) * Ns;
+		Ns *= plan->radices[s];
+	}
+
+	plan->twiddles = malloc ((numTwiddles > 0 ? numTwiddles : 1) * sizeof (adder_complex_rect));
+	if (plan->twiddles == 0x00) {
+		fprintf (stderr, "Failed to create FFT plan.\n");
+		deleteFFTPlan (plan);
+		return NULL;
+	}
+
+	Ns = 1;
+	for (s = 0; s < plan->numStages; s++) {
+		for (r = 1; r < plan->radices[s]; r++) {
+			for (i = 0; i < Ns; i++) {
+				plan->twiddles[plan->offsets[s] + (r - 1) * Ns + i] = twiddle ((long int)r * i, (long int)Ns * plan->radices[s]);
+			}
+		}
+
+		Ns *= plan->radices[s];
+	}
+
+	plan->scratchSize = n;
+
+	return plan;
+}
+
+/* Create a plan for transforms of real data of length n.
+ * Even lengths are transformed as complex data of length n / 2 */
+adder_fft_plan *
+fftPlanRealInit (int n)
+{
+	adder_fft_plan *plan;
+	int h = n / 2;
+	int k;
+
+	if (n <= 0) {
+		fprintf (stderr, "ERROR:  Transform length must be positive in function fftPlanRealInit.\n");
+		return NULL;
+	}
+
+	plan = calloc (1, sizeof (adder_fft_plan));
+	if (plan == 0x00) {
+		fprintf (stderr, "Failed to create FFT plan.\n");
+		return NULL;
+	}
+
+	plan->n = n;
+	plan->type = FFT_REAL;
+
+	if (n % 2 == 0) {
+		plan->sub = fftPlanInit (h);
+		plan->twiddles = malloc ((h + 1) * sizeof (adder_complex_rect));
+		if (plan->sub == 0x00 || plan->twiddles == 0x00) {
+			fprintf (stderr, "Failed to create FFT plan.\n");
+			deleteFFTPlan (plan);
+			return NULL;
+		}
+
+		for (k = 0; k <= h; k++) {
+			plan->twiddles[k] = twiddle (k, n);
+		}
+
+		plan->scratchSize = h + 1 + plan->sub->scratchSize;
+	}
+	else {
+		plan->sub = fftPlanInit (n);
+		if (plan->sub == 0x00) {
+			deleteFFTPlan (plan);
+			return NULL;
+		}
+
+		plan->scratchSize = n + plan->sub->scratchSize;
+	}
+
+	return plan;
+}
+
+/* Delete an FFT plan */
+void
+deleteFFTPlan (adder_fft_plan *plan)
+{
+	if (plan->sub != 0x00) {
+		deleteFFTPlan (plan->sub);
+	}
+
+	free (plan->twiddles);
+	free (plan->chirp);
+	free (plan->chirpSpectrum);
+	free (plan);
+}
+
+/* Number of complex elements of workspace the Workspace versions of the
+ * execute functions need for this plan */
+int
+fftWorkspaceSize (adder_fft_plan *plan)
+{
+	return plan->scratchSize;
+}
+
+/* Transform n complex values from in to out. direction is FFT_FORWARD or FFT_INVERSE */
+int
+fftExecute (adder_fft_plan *plan, adder_complex_rect *in, adder_complex_rect *out, int direction)
+{
+	adder_complex_rect *scratch;
+	int err;
+
+	scratch = malloc (plan->scratchSize * sizeof (adder_complex_rect));
+	if (scratch == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function fftExecute.\n");
+		return INIT_ERROR;
+	}
+
+	err = fftExecuteWorkspace (plan, in, out, direction, scratch);
+	free (scratch);
+
+	return err;
+}
+
+/* fftExecute using scratch, which has fftWorkspaceSize (plan) elements, instead
+ * of allocating a workspace. Each thread using the plan needs its own scratch */
+int
+fftExecuteWorkspace (adder_fft_plan *plan, adder_complex_rect *in, adder_complex_rect *out, int direction, adder_complex_rect *scratch)
+{
+	const double scale = 1.0 / plan->n;
+	int i;
+
+	if (plan->type != FFT_COMPLEX) {
+		fprintf (stderr, "ERROR:  Plan is not for complex transforms in function fftExecute.\n");
+		return ARGUMENT_ERROR;
+	}
+
+	if (direction != FFT_FORWARD && direction != FFT_INVERSE) {
+		fprintf (stderr, "ERROR:  Invalid direction in function fftExecute.\n");
+		return ARGUMENT_ERROR;
+	}
+
+	if (in != out) {
+		memcpy (out, in, plan->n * sizeof (adder_complex_rect));
+	}
+
+	transform (plan, out, scratch, direction);
+
+	if (direction == FFT_INVERSE) {
+		#pragma omp simd
+		for (i = 0; i < plan->n; i++) {
+			out[i].real *= scale;
+			out[i].imag *= scale;
+		}
+	}
+
+	return 0;
+}
+
+/* Transform n real values to the n / 2 + 1 complex values X[0] to X[n / 2].
+ * The rest of the transform follows from X[n - k] = conj (X[k]) */
+int
+fftExecuteReal (adder_fft_plan *plan, double *in, adder_complex_rect *out)
+{
+	adder_complex_rect *scratch;
+	int err;
+
+	scratch = malloc (plan->scratchSize * sizeof (adder_complex_rect));
+	if (scratch == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function fftExecuteReal.\n");
+		return INIT_ERROR;
+	}
+
+	err = fftExecuteRealWorkspace (plan, in, out, scratch);
+	free (scratch);
+
+	return err;
+}
+
+/* fftExecuteReal using scratch, which has fftWorkspaceSize (plan) elements */
+int
+fftExecuteRealWorkspace (adder_fft_plan *plan, double *in, adder_complex_rect *out, adder_complex_rect *scratch)
+{
+	const int n = plan->n;
+	const int h = n / 2;
+	adder_complex_rect *Z = scratch;
+	adder_complex_rect *w = plan->twiddles;
+	double er, ei, qr, qi;
+	int k, j;
+
+	if (plan->type != FFT_REAL) {
+		fprintf (stderr, "ERROR:  Plan is not for real transforms in function fftExecuteReal.\n");
+		return ARGUMENT_ERROR;
+	}
+
+	if (n % 2 != 0) {
+		for (j = 0; j < n; j++) {
+			Z[j].real = in[j];
+			Z[j].imag = 0;
+		}
+
+		transform (plan->sub, Z, scratch + n, FFT_FORWARD);
+		memcpy (out, Z, (h + 1) * sizeof (adder_complex_rect));
+
+		return 0;
+	}
+
+	/* Transform the even samples as the real part and the odd samples as the
+	 * imaginary part, then separate the two transforms E and O using their
+	 * symmetry and combine them as X[k] = E[k] + w^k * O[k] */
+	memcpy (Z, in, n * sizeof (double));
+	transform (plan->sub, Z, scratch + h + 1, FFT_FORWARD);
+	Z[h] = Z[0];
+
+	for (k = 0; k <= h; k++) {
+		/* E = (Z[k] + conj (Z[h - k])) / 2 and O = (Z[k] - conj (Z[h - k])) / 2i */
+		er = 0.5 * (Z[k].real + Z[h - k].real);
+		ei = 0.5 * (Z[k].imag - Z[h - k].imag);
+		qr = 0.5 * (Z[k].imag + Z[h - k].imag);
+		qi = -0.5 * (Z[k].real - Z[h - k].real);
+
+		out[k].real = er + w[k].real * qr - w[k].imag * qi;
+		out[k].imag = ei + w[k].real * qi + w[k].imag * qr;
+	}
+
+	return 0;
+}
+
+/* Transform the n / 2 + 1 complex values X[0] to X[n / 2] of the transform
+ * of real data back to the n real values. This is scaled by 1 / n. */
+int
+fftExecuteRealInverse (adder_fft_plan *plan, adder_complex_rect *in, double *out)
+{
+	adder_complex_rect *scratch;
+	int err;
+
+	scratch = malloc (plan->scratchSize * sizeof (adder_complex_rect));
+	if (scratch == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function fftExecuteRealInverse.\n");
+		return INIT_ERROR;
+	}
+
+	err = fftExecuteRealInverseWorkspace (plan, in, out, scratch);
+	free (scratch);
+
+	return err;
+}
+
+/* fftExecuteRealInverse using scratch, which has fftWorkspaceSize (plan) elements */
+int
+fftExecuteRealInverseWorkspace (adder_fft_plan *plan, adder_complex_rect *in, double *out, adder_complex_rect *scratch)
+{
+	const int n = plan->n;
+	const int h = n / 2;
+	adder_complex_rect *Z = scratch;
+	adder_complex_rect *w = plan->twiddles;
+	double er, ei, tr, ti, qr, qi;
+	int k, j;
+
+	if (plan->type != FFT_REAL) {
+		fprintf (stderr, "ERROR:  Plan is not for real transforms in function fftExecuteRealInverse.\n");
+		return ARGUMENT_ERROR;
+	}
+
+	if (n % 2 != 0) {
+		/* Rebuild the whole spectrum using X[n - k] = conj (X[k]) */
+		for (k = 0; k <= h; k++) {
+			Z[k] = in[k];
+			if (k > 0) {
+				Z[n - k].real = in[k].real;
+				Z[n - k].imag = -in[k].imag;
+			}
+		}
+
+		transform (plan->sub, Z, scratch + n, FFT_INVERSE);
+		for (j = 0; j < n; j++) {
+			out[j] = Z[j].real / n;
+		}
+
+		return 0;
+	}
+
+	/* Undo the combination in fftExecuteReal. E[k] = (X[k] + conj (X[h - k])) / 2 and
+	 * O[k] = conj (w^k) * (X[k] - conj (X[h - k])) / 2, then Z[k] = E[k] + i * O[k] */
+	for (k = 0; k < h; k++) {
+		er = 0.5 * (in[k].real + in[h - k].real);
+		ei = 0.5 * (in[k].imag - in[h - k].imag);
+		tr = 0.5 * (in[k].real - in[h - k].real);
+		ti = 0.5 * (in[k].imag + in[h - k].imag);
+		qr = w[k].real * tr + w[k].imag * ti;
+		qi = w[k].real * ti - w[k].imag * tr;
+
+		Z[k].real = (er - qi) / h;
+		Z[k].imag = (ei + qr) / h;
+	}
+
+	transform (plan->sub, Z, scratch + h + 1, FFT_INVERSE);
+	memcpy (out, Z, n * sizeof (double));
+
+	return 0;
+}
+
+/* Calculate the transform of a complex vector */
+static adder_complex_vector *
+vectorTransform (adder_complex_vector *z, int direction)
+{
+	adder_fft_plan *plan;
+	adder_complex_vector *res;
+
+	plan = fftPlanInit (z->size);
+	if (plan == 0x00) {
+		return NULL;
+	}
+
+	res = complexVectorInit2 (z->orientation, z->size);
+	if (res == 0x00) {
+		deleteFFTPlan (plan);
+		return NULL;
+	}
+
+	if (fftExecute (plan, z->vect, res->vect, direction) != 0) {
+		deleteComplexVector (res);
+		res = NULL;
+	}
+
+	deleteFFTPlan (plan);
+
+	return res;
+}
+
+/* Calculate the discrete Fourier transform of a complex vector */
+adder_complex_vector *
+fft (adder_complex_vector *z)
+{
+	return vectorTransform (z, FFT_FORWARD);
+}
+
+/* Calculate the inverse discrete Fourier transform of a complex vector */
+adder_complex_vector *
+ifft (adder_complex_vector *z)
+{
+	return vectorTransform (z, FFT_INVERSE);
+}
+
+/* Calculate the discrete Fourier transform of a real vector.
+ * The result has the v->size / 2 + 1 nonredundant values */
+adder_complex_vector *
+fftReal (adder_vector *v)
+{
+	adder_fft_plan *plan;
+	adder_complex_vector *res;
+
+	plan = fftPlanRealInit (v->size);
+	if (plan == 0x00) {
+		return NULL;
+	}
+
+	res = complexVectorInit2 (v->orientation, v->size / 2 + 1);
+	if (res == 0x00) {
+		deleteFFTPlan (plan);
+		return NULL;
+	}
+
+	if (fftExecuteReal (plan, v->vect, res->vect) != 0) {
+		deleteComplexVector (res);
+		res = NULL;
+	}
+
+	deleteFFTPlan (plan);
+
+	return res;
+}
+
+/* Calculate the inverse discrete Fourier transform of the n / 2 + 1 values
+ * from fftReal. n is needed since it can't be told from the size of z */
+adder_vector *
+ifftReal (adder_complex_vector *z, int n)
+{
+	adder_fft_plan *plan;
+	adder_vector *res;
+
+	if (z->size != n / 2 + 1) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function ifftReal.\n");
+		return NULL;
+	}
+
+	plan = fftPlanRealInit (n);
+	if (plan == 0x00) {
+		return NULL;
+	}
+
+	res = vectorInit2 (z->orientation, n);
+	if (res == 0x00) {
+		deleteFFTPlan (plan);
+		return NULL;
+	}
+
+	if (fftExecuteRealInverse (plan, z->vect, res->vect) != 0) {
+		deleteVector (res);
+		res = NULL;
+	}
+
+	deleteFFTPlan (plan);
+
+	return res;
+}
+
+/* Calculate the two-dimensional transform of a complex matrix by transforming
+ * every row and then every column. Rows and blocks of columns are divided
+ * between threads, and each thread has its own scratch space. */
+static adder_complex_matrix *
+matrixTransform (adder_complex_matrix *Z, int direction)
+{
+	const int rows = Z->rows;
+	const int columns = Z->columns;
+	adder_fft_plan *rowPlan;
+	adder_fft_plan *columnPlan;
+	adder_complex_matrix *res;
+	const double scale = 1.0 / ((double)rows * columns);
+	int failed = 0;
+	long int i;
+
+	rowPlan = fftPlanInit (columns);
+	columnPlan = fftPlanInit (rows);
+	res = complexMatrixInit2 (rows, columns);
+	if (rowPlan == 0x00 || columnPlan == 0x00 || res == 0x00) {
+		if (rowPlan != 0x00) {
+			deleteFFTPlan (rowPlan);
+		}
+
+		if (columnPlan != 0x00) {
+			deleteFFTPlan (columnPlan);
+		}
+
+		if (res != 0x00) {
+			deleteComplexMatrix (res);
+		}
+
+		return NULL;
+	}
+
+	memcpy (res->mat, Z->mat, (long int)rows * columns * sizeof (adder_complex_rect));
+
+	#pragma omp parallel reduction(|:failed)
+	{
+		adder_complex_rect *scratch;
+		adder_complex_rect *block;
+		int size;
+		int r, c, b, width;
+
+		size = rowPlan->scratchSize;
+		if (FFT_COLUMN_BLOCK * rows + columnPlan->scratchSize > size) {
+			size = FFT_COLUMN_BLOCK * rows + columnPlan->scratchSize;
+		}
+
+		scratch = malloc (size * sizeof (adder_complex_rect));
+		if (scratch == 0x00) {
+			failed = 1;
+		}
+
+		#pragma omp for schedule(static)
+		for (r = 0; r < rows; r++) {
+			if (scratch != 0x00) {
+				transform (rowPlan, &res->mat[(long int)r * columns], scratch, direction);
+			}
+		}
+
+		/* Columns are copied out a few at a time so each row is read
+		 * contiguously, transformed, and copied back */
+		#pragma omp for schedule(static)
+		for (c = 0; c < columns; c += FFT_COLUMN_BLOCK) {
+			if (scratch == 0x00) {
+				continue;
+			}
+
+			width = columns - c < FFT_COLUMN_BLOCK ? columns - c : FFT_COLUMN_BLOCK;
+			block = scratch + columnPlan->scratchSize;
+
+			for (r = 0; r < rows; r++) {
+				for (b = 0; b < width; b++) {
+					block[b * rows + r] = res->mat[(long int)r * columns + c + b];
+				}
+			}
+
+			for (b = 0; b < width; b++) {
+				transform (columnPlan, &block[b * rows], scratch, direction);
+			}
+
+			for (r = 0; r < rows; r++) {
+				for (b = 0; b < width; b++) {
+					res->mat[(long int)r * columns + c + b] = block[b * rows + r];
+				}
+			}
+		}
+
+		free (scratch);
+	}
+
+	deleteFFTPlan (rowPlan);
+	deleteFFTPlan (columnPlan);
+
+	if (failed) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function fft2.\n");
+		deleteComplexMatrix (res);
+		return NULL;
+	}
+
+	if (direction == FFT_INVERSE) {
+		#pragma omp parallel for simd
+		for (i = 0; i < (long int)rows * columns; i++) {
+			res->mat[i].real *= scale;
+			res->mat[i].imag *= scale;
+		}
+	}
+
+	return res;
+}
+
+/* Calculate the two-dimensional discrete Fourier transform of a complex matrix */
+adder_complex_matrix *
+fft2 (adder_complex_matrix *Z)
+{
+	return matrixTransform (Z, FFT_FORWARD);
+}
+
+/* Calculate the two-dimensional inverse discrete Fourier transform of a complex matrix */
+adder_complex_matrix *
+ifft2 (adder_complex_matrix *Z)
+{
+	return matrixTransform (Z, FFT_INVERSE);
+}
@@ -0,0 +1,83 @@
+/* fft.h
+ * Fast Fourier transforms of real and complex data.
+ *
+ * Lengths whose prime factors are 2, 3, and 5 use a mixed-radix Stockham
+ * algorithm, which works out of place so no bit reversal is needed and every
+ * stage reads and writes memory contiguously. Other lengths use Bluestein's
+ * algorithm, which turns the transform into a convolution of a smooth length.
+ *
+ * The forward transform is X[k] = sum x[j] * exp(-2 * pi * i * j * k / n) and
+ * is not scaled. The inverse transform is scaled by 1 / n, so the inverse of the
+ * forward transform gives back the original data.
+ *
+ * A plan holds the factorization and twiddle factors for one length and can be
+ * reused for any number of transforms. Plans are not changed by a transform, so
+ * one plan can be used by several threads at the same time. The execute
+ * functions allocate a workspace on every call, and the Workspace versions take
+ * one from the caller so repeated transforms don't allocate. */
+#ifndef ADDER_FFT_H
+#define ADDER_FFT_H
+
+#include "adder_matrix.h"
+
+#define ADDER_FFT_MAX_STAGES 32
+
+enum
+FFT_DIRECTION
+{
+	FFT_FORWARD = -1,
+	FFT_INVERSE = 1
+};
+
+enum
+FFT_TYPE
+{
+	FFT_COMPLEX = 1,
+	FFT_REAL = 2
+};
+
+/* FFT plan type definition */
+typedef struct adder_fft_plan
+{
+	int n; /* Transform length */
+	int type; /* One of FFT_TYPE */
+	int numStages; /* Number of radix stages, or zero for Bluestein plans */
+	int radices[ADDER_FFT_MAX_STAGES]; /* Radix of each stage */
+	int offsets[ADDER_FFT_MAX_STAGES]; /* Start of the twiddle factors of each stage */
+	adder_complex_rect *twiddles; /* Forward twiddle factors */
+	adder_complex_rect *chirp; /* Bluestein chirp exp(-i * pi * k^2 / n) */
+	adder_complex_rect *chirpSpectrum; /* Forward and inverse chirp filter spectra for Bluestein plans */
+	struct adder_fft_plan *sub; /* Smooth-length plan for Bluestein, or half-length plan for real transforms */
+	int m; /* Length of the Bluestein convolution */
+	int scratchSize; /* Number of complex elements of scratch space a transform needs */
+} adder_fft_plan;
+
+/* Plan functions */
+adder_fft_plan * fftPlanInit (int n);
+adder_fft_plan * fftPlanRealInit (int n);
+void deleteFFTPlan (adder_fft_plan *plan);
+int fftGoodSize (int n);
+int fftWorkspaceSize (adder_fft_plan *plan);
+
+/* Transforms of arrays using a plan. in and out may be the same array */
+int fftExecute (adder_fft_plan *plan, adder_complex_rect *in, adder_complex_rect *out, int direction);
+int fftExecuteReal (adder_fft_plan *plan, double *in, adder_complex_rect *out);
+int fftExecuteRealInverse (adder_fft_plan *plan, adder_complex_rect *in, double *out);
+
+/* Transforms that use a workspace of fftWorkspaceSize (plan) elements instead
+ * of allocating one on every call. Threads sharing a plan need separate workspaces */
+int fftExecuteWorkspace (adder_fft_plan *plan, adder_complex_rect *in, adder_complex_rect *out, int direction, adder_complex_rect *scratch);
+int fftExecuteRealWorkspace (adder_fft_plan *plan, double *in, adder_complex_rect *out, adder_complex_rect *scratch);
+int fftExecuteRealInverseWorkspace (adder_fft_plan *plan, adder_complex_rect *in, double *out, adder_complex_rect *scratch);
+
+/* Transforms of vectors */
+adder_complex_vector * fft (adder_complex_vector *z);
+adder_complex_vector * ifft (adder_complex_vector *z);
+adder_complex_vector * fftReal (adder_vector *v);
+adder_vector * ifftReal (adder_complex_vector *z, int n);
+
+/* Two-dimensional transforms of matrices */
+adder_complex_matrix * fft2 (adder_complex_matrix *Z);
+adder_complex_matrix * ifft2 (adder_complex_matrix *Z);
+
+#endif
@@ -0,0 +1,135 @@
+/* gauss.hpp
+ * Gauss-Legendre quadrature with rules generated at compile time (C++17).
+ *
+ * gauss<N> (f, a, b) integrates any callable f from a to b with the N point
+ * rule. The nodes and weights are calculated by constexpr functions when the
+ * program is compiled, to full double precision, and the sum is expanded
+ * into one expression per node with a fold expression. The integrand is
+ * called directly instead of through an adder_function pointer, so it can
+ * be inlined and a small rule compiles to a straight chain of multiply-adds.
+ *
+ * Rules are found with Newton's method on the Legendre recurrence, which
+ * takes O(N^2) steps at compile time. Compilers limit the number of constexpr
+ * operations, so rules with more than about 100 points should use
+ * gaussRuleCached from integration.h instead. */
+#ifndef ADDER_GAUSS_HPP
+#define ADDER_GAUSS_HPP
+
+#include <cstddef>
+#include <utility>
+
+/* Nodes in increasing order and weights of an N point rule on [-1, 1] */
+template <int N>
+struct adder_static_gauss_rule
+{
+	double nodes[N];
+	double weights[N];
+};
+
+namespace adder_gauss_detail
+{
+	constexpr long double PI = 3.141592653589793238462643383279502884L;
+
+	/* Taylor series for sin, accurate for |x| <= pi / 2 */
+	constexpr long double
+	sine (long double x)
+	{
+		long double term = x;
+		long double sum = x;
+
+		for (int k = 1; k < 30; k++) {
+			term *= -x * x / ((2 * k) * (2 * k + 1));
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	/* P_N (cos (theta)) and its derivative with respect to theta, with the
+	 * recurrence written in x - 1 = -2 sin^2 (theta / 2) to avoid cancellation
+	 * near x = +-1. Same method as the run time rules in integration.c */
+	constexpr void
+	legendre (int n, long double theta, long double &p, long double &dp)
+	{
+		const long double h = sine (theta / 2);
+		const long double y = -2 * h * h;
+		long double pj = 1;
+		long double d = 0;
+
+		for (int j = 1; j <= n; j++) {
+			d = ((2 * j - 1) * y * pj + (j - 1) * d) / j;
+			pj += d;
+		}
+
+		p = pj;
+		dp = n * (d + y * pj) / sine (theta);
+	}
+
+	template <int N>
+	constexpr adder_static_gauss_rule<N>
+	generate ()
+	{
+		adder_static_gauss_rule<N> rule {};
+
+		for (int k = 1; k <= (N + 1) / 2; k++) {
+			long double theta = PI * (4 * k - 1) / (4.0L * N + 2);
+			long double p = 0, dp = 1, delta = 1;
+
+			for (int i = 0; i < 20 && delta != 0; i++) {
+				legendre (N, theta, p, dp);
+				delta = p / dp;
+				theta -= delta;
+			}
+
+			legendre (N, theta, p, dp);
+
+			/* cos (theta) = 1 - 2 sin^2 (theta / 2) */
+			const long double h = sine (theta / 2);
+			const double x = static_cast<double> (1 - 2 * h * h);
+			const double w = static_cast<double> (2 / (dp * dp));
+
+			rule.nodes[k - 1] = -x;
+			rule.nodes[N - k] = x;
+			rule.weights[k - 1] = w;
+			rule.weights[N - k] = w;
+		}
+
+		if (N % 2 == 1) {
+			rule.nodes[N / 2] = 0;
+		}
+
+		return rule;
+	}
+
+	template <int N, typename F, std::size_t... I>
+	inline double
+	sum (F &f, double mul1, double mul2, std::index_sequence<I...>);
+}
+
+/* The N point rule, calculated once at compile time */
+template <int N>
+inline constexpr adder_static_gauss_rule<N> gaussRuleConstant = adder_gauss_detail::generate<N> ();
+
+template <int N, typename F, std::size_t... I>
+inline double
+adder_gauss_detail::sum (F &f, double mul1, double mul2, std::index_sequence<I...>)
+{
+	return ((gaussRuleConstant<N>.weights[I] * f (mul1 * gaussRuleConstant<N>.nodes[I] + mul2)) + ...);
+}
+
+/* Integrate f from a to b with the N point Gauss-Legendre rule.
+ * f is any callable taking and returning double */
+template <int N, typename F>
+inline double
+gauss (F f, double a, double b)
+{
+	static_assert (N >= 1, "A Gauss-Legendre rule needs at least one point");
+
+	/* Transform the bounds from [a,b] to [-1,1] */
+	const double mul1 = (b - a) / 2;
+	const double mul2 = (b + a) / 2;
+
+	return mul1 * adder_gauss_detail::sum<N> (f, mul1, mul2, std::make_index_sequence<N> ());
+}
+
+#endif
@@ -3,9 +3,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <float.h> /* For DBL_EPSILON, DBL_MIN, and DBL_MAX */
+#include <limits.h> /* For INT_MAX */
 #include <time.h>
+#include <pthread.h>
 #include "adder_integration.h"
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 /* Three point Gauss-Legendre quadrature
  * f is the function to be integrated
  * a is the lower bound of integration
@@ -13,8 +20,8 @@
 double
 gauss3 (adder_function *f, double a, double b)
 {
-	const double xi[3] = {-.7745966692, 0.0, .7745966692}; /* Abscissas */
-	const double wi[3] = {.5555554736, .8888888889, .5555554736}; /* Weights */
+	const double xi[3] = {-0.77459666924148338, 0.0, 0.77459666924148338}; /* Abscissas, +-sqrt (3/5) */
+	const double wi[3] = {0.55555555555555556, 0.88888888888888889, 0.55555555555555556}; /* Weights, 5/9 and 8/9 */
 	double x;
 	double mul1, mul2, mul3;
 	double fValue;
@@ -29,15 +36,15 @@ gauss3 (adder_function *f, double a, double b)
 	/* Now perform the integration.
 	 * The loop is unrolled since there are only three points */
 	x = mul2 * xi[0] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[0] * fValue;
 
 	x = mul2 * xi[1] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[1] * fValue;
 
 	x = mul2 * xi[2] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[2] * fValue;
 
 	/* Multiply res by mul1 to get the final result */
@@ -53,8 +60,8 @@ gauss3 (adder_function *f, double a, double b)
 double
 gauss5 (adder_function *f, double a, double b)
 {
-	const double xi[5] = {-0.9061798459, -0.5384693101, 0.0, 0.5384693101, 0.9061798459};
-	const double wi[5] = {0.2369268005, 0.4786286705, 0.5688888889, 0.4786286705, 0.2369268005};
+	const double xi[5] = {-0.90617984593866399, -0.53846931010568309, 0.0, 0.53846931010568309, 0.90617984593866399};
+	const double wi[5] = {0.23692688505618909, 0.47862867049936647, 0.56888888888888889, 0.47862867049936647, 0.23692688505618909};
 	double x;
 	double mul1, mul2, mul3;
 	double fValue;
@@ -68,23 +75,23 @@ gauss5 (adder_function *f, double a, double b)
 
 	/* Now perform the integration */
 	x = mul2 * xi[0] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[0] * fValue;
 
 	x = mul2 * xi[1] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[1] * fValue;
 
 	x = mul2 * xi[2] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[2] * fValue;
 
 	x = mul2 * xi[3] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[3] * fValue;
 
 	x = mul2 * xi[4] + mul3;
-	fValue = f->function (x);
+	fValue = evaluateFunction (f, x);
 	res += wi[4] * fValue;
 
 	/* Multiply res by mul1 to get the final result */
@@ -100,22 +107,22 @@ gauss5 (adder_function *f, double a, double b)
 double
 gauss20 (adder_function *f, double a, double b)
 {
-	const double xi[20] = {-0.9931285992, -0.9639719273, -0.9122344283, -0.8391169718,
-			      -0.7463319065, -0.6360536807, -0.5108670020, -0.3737060887,
-			      -0.2277858511, -0.0765265211, 0.0765265211, 0.2277858511,
-			       0.3737060887, 0.5108670020, 0.6360536807, 0.7463319065,
-			       0.8391169718, 0.9122344283, 0.9639719273, 0.9931285992};
-
-	const double wi[20] = {0.0176139968, 0.0406014298, 0.0626720483, 0.0832767416,
-			       0.1019300655, 0.1181945135, 0.1316886329, 0.1420961081,
-			       0.1491729863, 0.1527533871, 0.1527533871, 0.1491729863,
-			       0.1420961081, 0.1316886329, 0.1181945135, 0.1019300655,
-			       0.0832767416, 0.0626720483, 0.0406014298, 0.0176139968};
+	const double xi[20] = {-0.99312859918509492, -0.96397192727791379, -0.91223442825132591, -0.83911697182221882,
+			      -0.74633190646015079, -0.63605368072651503, -0.51086700195082710, -0.37370608871541956,
+			      -0.22778585114164508, -0.076526521133497334, 0.076526521133497334, 0.22778585114164508,
+			       0.37370608871541956, 0.51086700195082710, 0.63605368072651503, 0.74633190646015079,
+			       0.83911697182221882, 0.91223442825132591, 0.96397192727791379, 0.99312859918509492};
+
+	const double wi[20] = {0.017614007139152118, 0.040601429800386941, 0.062672048334109064, 0.083276741576704749,
+			       0.10193011981724044, 0.11819453196151842, 0.13168863844917663, 0.14209610931838205,
+			       0.14917298647260375, 0.15275338713072585, 0.15275338713072585, 0.14917298647260375,
+			       0.14209610931838205, 0.13168863844917663, 0.11819453196151842, 0.10193011981724044,
+			       0.083276741576704749, 0.062672048334109064, 0.040601429800386941, 0.017614007139152118};
 
 	double x;
 	double mul1, mul2, mul3;
 	double fValue;
-	double res;
+	double res = 0;
 	int i;
 
 	/* The first step is to transform the bounds from [a,b] to [-1,1] */
@@ -126,7 +133,7 @@ gauss20 (adder_function *f, double a, double b)
 	/* Perform the integration */
 	for (i = 0; i < 20; i++) {
 		x = mul2 * xi[i] + mul3;
-		fValue = f->function (x);
+		fValue = evaluateFunction (f, x);
 		res += wi[i] * fValue;
 	}
 
@@ -136,250 +143,1551 @@ gauss20 (adder_function *f, double a, double b)
 	return res;
 }
 
+/* Fifty point Gauss-Legendre quadrature
+ * f is the function to be integrated
+ * a is the lower bound of integration
+ * b is the upper bound of integration
+ * Returns NaN if the rule couldn't be created */
+double
+gauss50 (adder_function *f, double a, double b)
+{
+	adder_gauss_rule *rule;
+
+	rule = gaussRuleCached (50);
+	if (rule == NULL) {
+		return NAN;
+	}
+
+	return gaussRuleIntegrate (rule, f, a, b);
+}
+
+/* One hundred point Gauss-Legendre quadrature
+ * f is the function to be integrated
+ * a is the lower bound of integration
+ * b is the upper bound of integration
+ * Returns NaN if the rule couldn't be created */
+double
+gauss100 (adder_function *f, double a, double b)
+{
+	adder_gauss_rule *rule;
+
+	rule = gaussRuleCached (100);
+	if (rule == NULL) {
+		return NAN;
+	}
+
+	return gaussRuleIntegrate (rule, f, a, b);
+}
+
+/*******************************
+ * Gauss-Legendre rules        *
+ *******************************/
+
+/* Number of nodes at each end of a large rule that are found with the
+ * recurrence, since the asymptotic expansion is inaccurate near +-1 */
+#define GAUSS_BOUNDARY_NODES 20
+
+/* Number of terms of the asymptotic expansion */
+#define GAUSS_EXPANSION_TERMS 20
+
+#define GAUSS_MAX_ITERATIONS 10
+#define GAUSS_CACHE_BUCKETS 64
+
+/* Entry in the cache of rules */
+typedef struct gauss_cache_entry
+{
+	adder_gauss_rule *rule;
+	struct gauss_cache_entry *next;
+} gauss_cache_entry;
+
+static gauss_cache_entry *gaussCache[GAUSS_CACHE_BUCKETS];
+static pthread_mutex_t gaussCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Calculate P_N (cos (theta)) and its derivative with respect to theta
+ * using the three-term recurrence. The recurrence is written in terms of
+ * x - 1 = -2 sin^2 (theta / 2) and the differences P_j - P_(j-1), so there
+ * is no cancellation near x = +-1. Takes O(N) operations. */
+static void
+legendreRecurrence (int N, double theta, double *p, double *dp)
+{
+	double h = sin (theta / 2);
+	double y = -2 * h * h; /* x - 1 */
+	double pj = 1; /* P_j */
+	double d = 0; /* P_j - P_(j-1) */
+	int j;
+
+	for (j = 1; j <= N; j++) {
+		d = ((2 * j - 1) * y * pj + (j - 1) * d) / j;
+		pj += d;
+	}
+
+	*p = pj;
+
+	/* dP/dtheta = -sin (theta) P'(x) = N (x P_N - P_(N-1)) / sin (theta) */
+	*dp = N * (d + y * pj) / sin (theta);
+}
+
+/* Calculate P_N (cos (theta)) and its derivative with respect to theta with
+ * the Stieltjes asymptotic expansion in O(1) operations
+ *
+ *   P_N (cos (theta)) = C_N * sum over m of h_m cos (a_m) / (2 sin (theta))^(m + 1/2)
+ *
+ * where a_m = (N + m + 1/2) theta - (m + 1/2) pi / 2 and h_m is the product of
+ * (j - 1/2)^2 / (j (N + j + 1/2)) for j = 1..m. It is accurate when N sin (theta)
+ * is large, which is every node except the first few at each end.
+ * See Hale and Townsend, "Fast and accurate computation of Gauss-Legendre and
+ * Gauss-Jacobi quadrature nodes and weights" (https://doi.org/10.1137/120889873) */
+static void
+legendreAsymptotic (int N, double theta, double *p, double *dp)
+{
+	const double s = sin (theta);
+	const double c = cos (theta);
+	const double z = N + 1.0;
+	double cosA, sinA, t;
+	double q, h, g, C;
+	double sum = 0, dsum = 0;
+	int m;
+
+	/* C_N = 2 / sqrt (pi) * Gamma (N + 1) / Gamma (N + 3/2), using the
+	 * expansion of Gamma (z + 1/2) / (Gamma (z) sqrt (z)) for z = N + 1 */
+	g = 1 + (-1.0 / 8 + (1.0 / 128 + (5.0 / 1024 + (-21.0 / 32768 + (-399.0 / 262144 + 869.0 / 4194304 / z) / z) / z) / z) / z) / z;
+	C = 2 / (sqrt (M_PI * z) * g);
+
+	/* a_(m+1) = a_m + theta - pi / 2, so the cosines and sines of the
+	 * angles are found by rotation instead of calling cos and sin */
+	t = (N + 0.5) * theta - M_PI / 4;
+	cosA = cos (t);
+	sinA = sin (t);
+
+	q = 1 / sqrt (2 * s);
+	h = 1;
+	for (m = 0; m < GAUSS_EXPANSION_TERMS; m++) {
+		sum += h * q * cosA;
+		dsum -= h * q * ((N + m + 0.5) * sinA + (m + 0.5) * cosA * c / s);
+
+		t = sinA * c + cosA * s;
+		sinA = sinA * s - cosA * c;
+		cosA = t;
+
+		h *= (m + 0.5) * (m + 0.5) / ((m + 1) * (N + m + 1.5));
+		q /= 2 * s;
+	}
+
+	*p = C * sum;
+	*dp = C * dsum;
+}
+
+/* Calculate the nodes and weights of the N point rule.
+ *
+ * Node k from the right end is the root of P_N near theta = pi (4k - 1) / (4N + 2),
+ * and is found with Newton's method in theta. Working in theta keeps the
+ * nodes near +-1 accurate and gives the weights as 2 / (dP/dtheta)^2 with no
+ * cancellation. For N < GAUSS_ASYMPTOTIC_SIZE the recurrence is used for
+ * every node, which is O(N^2). For larger N it's only used for the
+ * GAUSS_BOUNDARY_NODES nodes at each end and the asymptotic expansion is used
+ * for the rest, so the total work is O(N). */
+static void
+gaussLegendreNodes (int N, double *x, double *w)
+{
+	double theta, delta;
+	double p, dp;
+	int useRecurrence;
+	int i, k;
+	int m = (N + 1) / 2;
+
+	for (k = 1; k <= m; k++) {
+		useRecurrence = N < GAUSS_ASYMPTOTIC_SIZE || k <= GAUSS_BOUNDARY_NODES;
+		theta = M_PI * (4 * k - 1) / (4.0 * N + 2);
+
+		for (i = 0; i < GAUSS_MAX_ITERATIONS; i++) {
+			if (useRecurrence) {
+				legendreRecurrence (N, theta, &p, &dp);
+			}
+			else {
+				legendreAsymptotic (N, theta, &p, &dp);
+			}
+
+			delta = p / dp;
+			theta -= delta;
+
+			if (fabs (delta) <= __DBL_EPSILON__ * theta) {
+				break;
+			}
+		}
+
+		/* The derivative at the final node gives the weight */
+		if (useRecurrence) {
+			legendreRecurrence (N, theta, &p, &dp);
+		}
+		else {
+			legendreAsymptotic (N, theta, &p, &dp);
+		}
+
+		x[k - 1] = -cos (theta);
+		x[N - k] = cos (theta);
+		w[k - 1] = 2 / (dp * dp);
+		w[N - k] = w[k - 1];
+	}
+
+	/* The middle node of an odd rule is exactly 0 */
+	if (N % 2 == 1) {
+		x[N / 2] = 0;
+	}
+}
+
+/* Create the N point Gauss-Legendre rule on [-1, 1] */
+adder_gauss_rule *
+gaussRuleInit (int N)
+{
+	adder_gauss_rule *rule;
+
+	if (N < 1) {
+		fprintf (stderr, "ERROR:  Invalid number of points in function gaussRuleInit.\n");
+		return NULL;
+	}
+
+	rule = malloc (sizeof (adder_gauss_rule));
+	if (rule == 0x00) {
+		fprintf (stderr, "Failed to create Gauss-Legendre rule.\n");
+		return NULL;
+	}
+
+	rule->nodes = malloc (N * sizeof (double));
+	rule->weights = malloc (N * sizeof (double));
+	if (rule->nodes == 0x00 || rule->weights == 0x00) {
+		fprintf (stderr, "Failed to create Gauss-Legendre rule.\n");
+		free (rule->nodes);
+		free (rule->weights);
+		free (rule);
+		return NULL;
+	}
+
+	rule->n = N;
+	gaussLegendreNodes (N, rule->nodes, rule->weights);
+
+	return rule;
+}
+
+/* Delete a Gauss-Legendre rule */
+void
+deleteGaussRule (adder_gauss_rule *rule)
+{
+	free (rule->nodes);
+	free (rule->weights);
+	free (rule);
+}
+
+/* Return the N point rule from a cache shared by all threads, creating it
+ * the first time it's needed. The rule stays valid until gaussRuleCacheClear
+ * is called and must not be deleted by the caller. */
+adder_gauss_rule *
+gaussRuleCached (int N)
+{
+	gauss_cache_entry *entry;
+	adder_gauss_rule *rule;
+	int bucket;
+
+	if (N < 1) {
+		fprintf (stderr, "ERROR:  Invalid number of points in function gaussRuleCached.\n");
+		return NULL;
+	}
+
+	bucket = N % GAUSS_CACHE_BUCKETS;
+
+	pthread_mutex_lock (&gaussCacheLock);
+	for (entry = gaussCache[bucket]; entry != NULL; entry = entry->next) {
+		if (entry->rule->n == N) {
+			rule = entry->rule;
+			pthread_mutex_unlock (&gaussCacheLock);
+			return rule;
+		}
+	}
+	pthread_mutex_unlock (&gaussCacheLock);
+
+	/* Create the rule without holding the lock, so other threads can
+	 * keep using the cache while a large rule is generated */
+	rule = gaussRuleInit (N);
+	if (rule == NULL) {
+		return NULL;
+	}
+
+	entry = malloc (sizeof (gauss_cache_entry));
+	if (entry == NULL) {
+		fprintf (stderr, "Failed to create Gauss-Legendre rule.\n");
+		deleteGaussRule (rule);
+		return NULL;
+	}
+
+	pthread_mutex_lock (&gaussCacheLock);
+
+	/* Another thread may have added the same rule in the meantime */
+	for (entry->next = gaussCache[bucket]; entry->next != NULL; entry->next = entry->next->next) {
+		if (entry->next->rule->n == N) {
+			deleteGaussRule (rule);
+			rule = entry->next->rule;
+			pthread_mutex_unlock (&gaussCacheLock);
+			free (entry);
+			return rule;
+		}
+	}
+
+	entry->rule = rule;
+	entry->next = gaussCache[bucket];
+	gaussCache[bucket] = entry;
+
+	pthread_mutex_unlock (&gaussCacheLock);
+
+	return rule;
+}
+
+/* Delete every cached rule. No rule returned by gaussRuleCached may be
+ * in use by any thread when this is called. */
+void
+gaussRuleCacheClear ()
+{
+	gauss_cache_entry *entry, *next;
+	int i;
+
+	pthread_mutex_lock (&gaussCacheLock);
+	for (i = 0; i < GAUSS_CACHE_BUCKETS; i++) {
+		for (entry = gaussCache[i]; entry != NULL; entry = next) {
+			next = entry->next;
+			deleteGaussRule (entry->rule);
+			free (entry);
+		}
+
+		gaussCache[i] = NULL;
+	}
+	pthread_mutex_unlock (&gaussCacheLock);
+}
+
+/* Integrate f from a to b with a Gauss-Legendre rule */
+double
+gaussRuleIntegrate (adder_gauss_rule *rule, adder_function *f, double a, double b)
+{
+	double mul1, mul2;
+	double res = 0;
+	int i;
+
+	/* Transform the bounds from [a,b] to [-1,1] */
+	mul1 = (b - a) / 2;
+	mul2 = (b + a) / 2;
+
+	for (i = 0; i < rule->n; i++) {
+		res += rule->weights[i] * evaluateFunction (f, mul1 * rule->nodes[i] + mul2);
+	}
+
+	return res * mul1;
+}
+
+/* Integrate a batch function from a to b with a Gauss-Legendre rule.
+ * All nodes are passed to f in one call */
+double
+gaussRuleIntegrateBatch (adder_gauss_rule *rule, adder_batch_function *f, double a, double b)
+{
+	double *x, *y;
+	double mul1, mul2;
+	double res = 0;
+	int i;
+
+	x = malloc ((size_t)2 * rule->n * sizeof (double));
+	if (x == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function gaussRuleIntegrateBatch.\n");
+		return NAN;
+	}
+
+	y = x + rule->n;
+
+	/* Transform the bounds from [a,b] to [-1,1] */
+	mul1 = (b - a) / 2;
+	mul2 = (b + a) / 2;
+
+	for (i = 0; i < rule->n; i++) {
+		x[i] = mul1 * rule->nodes[i] + mul2;
+	}
+
+	f->function (x, y, rule->n, f->data);
+
+	for (i = 0; i < rule->n; i++) {
+		res += rule->weights[i] * y[i];
+	}
+
+	free (x);
+
+	return res * mul1;
+}
+
 /* General Gauss-Legendre quadrature
-  * Since the number of points to use is only known at run time, the
- * weights and abscissas are not calculated beforehand
  * f is the function to be integrated
  * a is the lower bound of integration
  * b is the upper bound of integration
  * N is the number of points to use
  *
- * Routine is a reimplementation of that by Pazus at
- * https://github.com/Pazus/Legendre-Gauss-Quadrature */
+ * The rule for N points is calculated the first time it's used and cached,
+ * so later calls with the same N only evaluate the function. */
 int
 galeQuad (adder_function *f, double *res, double a, double b, int N)
 {
-	double *xi;
-	double *wi;
-	double mul1, mul2, mul3;
-	double fValue;
-	double x;
-	double z, z1;
-	double p, p1, p2, p3;
-	double h;
-	int i, j;
-	int m;
-//	double res = 0;
-	const double PI = 3.14159265358979323846; /* Needed because M_PI isn't part of the standard math library */
+	adder_gauss_rule *rule;
 
-	/* Allocate the arrays of weights and abscissas */
-	xi = malloc (N * sizeof (double));
-	if (xi == 0x00) {
+	rule = gaussRuleCached (N);
+	if (rule == NULL) {
 		return INTEGRAL_ERROR;
 	}
 
-	wi = malloc (N * sizeof (double));
-	if (wi == 0x00) {
-		free (xi);
+	*res = gaussRuleIntegrate (rule, f, a, b);
+
+	return INTEGRAL_SUCCESS;
+}
+
+/* General Gauss-Legendre quadrature of a batch function.
+ * The arguments are the same as for galeQuad */
+int
+galeQuadBatch (adder_batch_function *f, double *res, double a, double b, int N)
+{
+	adder_gauss_rule *rule;
+
+	rule = gaussRuleCached (N);
+	if (rule == NULL) {
 		return INTEGRAL_ERROR;
 	}
 
-	/* Check if the number of points to be used is an even number */
-	if (N % 2 == 0) {
-		m = N / 2;
+	*res = gaussRuleIntegrateBatch (rule, f, a, b);
+
+	return INTEGRAL_SUCCESS;
+}
+
+/*******************************
+ * Adaptive integration        *
+ *******************************/
+
+/* Size of the table for Wynn's epsilon algorithm, which keeps at most 50 elements */
+#define EPSILON_TABLE_SIZE 52
+
+/* Nodes and weights of a Gauss-Kronrod rule. The Kronrod nodes on (0, 1]
+ * are listed in decreasing order followed by 0, and the odd-numbered ones
+ * are the nodes of the Gauss rule. The Gauss weights follow the same order,
+ * with the weight of 0 last when the Gauss rule has an odd number of points */
+typedef struct
+{
+	int n; /* Number of Gauss points */
+	const double *xgk; /* Kronrod nodes, n + 1 */
+	const double *wgk; /* Kronrod weights, n + 1 */
+	const double *wg; /* Gauss weights, (n + 1) / 2 */
+} gauss_kronrod_rule;
+
+/* Constants from QUADPACK's qk15 and qk21 */
+static const double xgk15[8] = {
+	0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+	0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+	0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+	0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+
+static const double wgk15[8] = {
+	0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+	0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+	0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+	0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+
+static const double wg7[4] = {
+	0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+	0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+static const double xgk21[11] = {
+	0.995657163025808080735527280689003, 0.973906528517171720077964012084452,
+	0.930157491355708226001207180059508, 0.865063366688984510732096688423493,
+	0.780817726586416897063717578345042, 0.679409568299024406234327365114874,
+	0.562757134668604683339000099272694, 0.433395394129247190799265943165784,
+	0.294392862701460198131126603103866, 0.148874338981631210884826001129720,
+	0.000000000000000000000000000000000};
+
+static const double wgk21[11] = {
+	0.011694638867371874278064396062192, 0.032558162307964727478818972459390,
+	0.054755896574351996031381300244580, 0.075039674810919952767043140916190,
+	0.093125454583697605535065465083366, 0.109387158802297641899210590325805,
+	0.123491976262065851077958109831074, 0.134709217311473325928054001771707,
+	0.142775938577060080797094273138717, 0.147739104901338491374841515972068,
+	0.149445554002916905664936468389821};
+
+static const double wg10[5] = {
+	0.066671344308688137593568809893332, 0.149451349150580593145776339657697,
+	0.219086362515982043995534934228163, 0.269266719309996355091226921569469,
+	0.295524224714752870173892994651338};
+
+static const gauss_kronrod_rule gaussKronrod15 = {7, xgk15, wgk15, wg7};
+static const gauss_kronrod_rule gaussKronrod21 = {10, xgk21, wgk21, wg10};
+
+/* Subinterval of an adaptive integration */
+typedef struct
+{
+	double a;
+	double b;
+	double result;
+	double error;
+} quad_interval;
+
+/* Return the rule for GAUSS_KRONROD_15 or GAUSS_KRONROD_21, or NULL */
+static const gauss_kronrod_rule *
+gaussKronrodRule (int rule)
+{
+	if (rule == GAUSS_KRONROD_15) {
+		return &gaussKronrod15;
 	}
-	else {
-		m = (N + 1) / 2;
+	else if (rule == GAUSS_KRONROD_21) {
+		return &gaussKronrod21;
+	}
+
+	return NULL;
+}
+
+/* Apply a Gauss-Kronrod rule to f on [a, b]. result is the Kronrod estimate
+ * and error the estimate of its error, scaled as in QUADPACK. resabs is the
+ * integral of |f| and resasc the integral of |f - mean|, which are used to
+ * detect roundoff. */
+static void
+gaussKronrod (adder_function *f, const gauss_kronrod_rule *gk, double a, double b, double *result, double *error, double *resabs, double *resasc)
+{
+	const int n = gk->n;
+	const double center = (a + b) / 2;
+	const double halfLength = (b - a) / 2;
+	const double absHalfLength = fabs (halfLength);
+	double fv1[10], fv2[10]; /* f at the nodes left and right of the center */
+	double fc, f1, f2, x;
+	double resg, resk, reskh;
+	int j, k;
+
+	fc = evaluateFunction (f, center);
+	resk = gk->wgk[n] * fc;
+	resg = (n % 2 == 1) ? gk->wg[n / 2] * fc : 0;
+	*resabs = fabs (resk);
+
+	for (j = 0; j < n; j++) {
+		x = halfLength * gk->xgk[j];
+		f1 = evaluateFunction (f, center - x);
+		f2 = evaluateFunction (f, center + x);
+		fv1[j] = f1;
+		fv2[j] = f2;
+
+		/* Odd-numbered nodes are shared with the Gauss rule */
+		if (j % 2 == 1) {
+			resg += gk->wg[j / 2] * (f1 + f2);
+		}
+
+		resk += gk->wgk[j] * (f1 + f2);
+		*resabs += gk->wgk[j] * (fabs (f1) + fabs (f2));
+	}
+
+	reskh = resk / 2;
+	*resasc = gk->wgk[n] * fabs (fc - reskh);
+	for (k = 0; k < n; k++) {
+		*resasc += gk->wgk[k] * (fabs (fv1[k] - reskh) + fabs (fv2[k] - reskh));
+	}
+
+	*result = resk * halfLength;
+	*resabs *= absHalfLength;
+	*resasc *= absHalfLength;
+	*error = fabs ((resk - resg) * halfLength);
+
+	if (*resasc != 0 && *error != 0) {
+		*error = *resasc * fmin (1, pow (200 * *error / *resasc, 1.5));
+	}
+
+	if (*resabs > DBL_MIN / (50 * DBL_EPSILON)) {
+		*error = fmax (50 * DBL_EPSILON * *resabs, *error);
+	}
+}
+
+/* Add an interval to a max-heap ordered by error */
+static void
+intervalPush (quad_interval *heap, int *size, quad_interval item)
+{
+	int i = (*size)++;
+	int parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (heap[parent].error >= item.error) {
+			break;
+		}
+
+		heap[i] = heap[parent];
+		i = parent;
+	}
+
+	heap[i] = item;
+}
+
+/* Remove and return element i of a max-heap */
+static quad_interval
+intervalRemove (quad_interval *heap, int *size, int i)
+{
+	quad_interval removed = heap[i];
+	quad_interval last = heap[--(*size)];
+	int child;
+
+	if (i == *size) {
+		return removed;
+	}
+
+	/* Move the last element into the hole, up if it's larger than the parent */
+	while (i > 0 && heap[(i - 1) / 2].error < last.error) {
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+
+	/* or down if it's smaller than a child */
+	for (;;) {
+		child = 2 * i + 1;
+		if (child >= *size) {
+			break;
+		}
+
+		if (child + 1 < *size && heap[child + 1].error > heap[child].error) {
+			child++;
+		}
+
+		if (heap[child].error <= last.error) {
+			break;
+		}
+
+		heap[i] = heap[child];
+		i = child;
+	}
+
+	heap[i] = last;
+
+	return removed;
+}
+
+/* Sum the results of the intervals */
+static double
+intervalSum (quad_interval *heap, int size)
+{
+	double sum = 0;
+	int i;
+
+	for (i = 0; i < size; i++) {
+		sum += heap[i].result;
 	}
 
-	/* Calculate the abscissas and weights */
-	for (i = 1; i <= m; i++) {
-		z = cos(PI * (i - 0.25) / ((double)N + 0.5)); //initial estimate
-		z1 = z + 1;
+	return sum;
+}
 
-		while (fabs (z - z1) > __DBL_EPSILON__) {
-			p1 = 1;
-			p2 = 0;
+/* Check the arguments of the adaptive routines and allocate the heap.
+ * Each bisection adds one interval and costs two rule evaluations */
+static quad_interval *
+adaptiveInit (const char *name, int rule, double epsAbs, double epsRel, long int maxEvaluations, const gauss_kronrod_rule **gk, int *capacity)
+{
+	quad_interval *heap;
+	long int bisections;
+
+	*gk = gaussKronrodRule (rule);
+	if (*gk == NULL) {
+		fprintf (stderr, "ERROR:  Invalid Gauss-Kronrod rule in function %s.\n", name);
+		return NULL;
+	}
+
+	if (epsAbs <= 0 && epsRel < fmax (50 * DBL_EPSILON, 0.5e-28)) {
+		fprintf (stderr, "ERROR:  Tolerance can't be met in function %s.\n", name);
+		return NULL;
+	}
+
+	if (maxEvaluations < rule) {
+		fprintf (stderr, "ERROR:  Evaluation budget is too small in function %s.\n", name);
+		return NULL;
+	}
 
-			for (j = 1; j <= N; j++) {
-				p3 = p2;
-				p2 = p1;
-				p1 = ((2 * j - 1) * z * p2 - (j - 1) * p3) / j; //The Legendre Polynomial
+	bisections = (maxEvaluations - rule) / (2 * rule);
+	if (bisections > INT_MAX - 1) {
+		bisections = INT_MAX - 1;
+	}
+
+	*capacity = (int)bisections + 1;
+	heap = malloc (*capacity * sizeof (quad_interval));
+	if (heap == NULL) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function %s.\n", name);
+	}
+
+	return heap;
+}
+
+/* Adaptive integration of f from a to b without extrapolation (QUADPACK's QAG).
+ * f is the function to be integrated
+ * a is the lower bound of integration
+ * b is the upper bound of integration
+ * epsAbs and epsRel are the absolute and relative error tolerances
+ * rule is GAUSS_KRONROD_15 or GAUSS_KRONROD_21
+ * maxEvaluations is the largest number of times f may be evaluated
+ * res is set to the integral and err to the estimate of its absolute error */
+int
+adaptiveIntegrate (adder_function *f, double a, double b, double epsAbs, double epsRel, int rule, long int maxEvaluations, double *res, double *err)
+{
+	const gauss_kronrod_rule *gk;
+	quad_interval *heap;
+	quad_interval current, left, right;
+	double area, errsum, errbnd;
+	double area12, erro12;
+	double resabs, resasc, defab1, defab2;
+	long int evaluations;
+	int size = 0, capacity;
+	int iroff1 = 0, iroff2 = 0;
+	int status = INTEGRAL_SUCCESS;
+
+	heap = adaptiveInit ("adaptiveIntegrate", rule, epsAbs, epsRel, maxEvaluations, &gk, &capacity);
+	if (heap == NULL) {
+		return INTEGRAL_ERROR;
+	}
+
+	/* First approximation to the integral */
+	current.a = a;
+	current.b = b;
+	gaussKronrod (f, gk, a, b, &current.result, &current.error, &resabs, &resasc);
+	evaluations = rule;
+
+	errbnd = fmax (epsAbs, epsRel * fabs (current.result));
+	if (current.error <= 50 * DBL_EPSILON * resabs && current.error > errbnd) {
+		status = INTEGRAL_ROUNDOFF;
+	}
+	else if (capacity == 1 && current.error > errbnd) {
+		status = INTEGRAL_MAX_EVALUATIONS;
+	}
+
+	if (status != INTEGRAL_SUCCESS || (current.error <= errbnd && current.error != resasc) || current.error == 0) {
+		*res = current.result;
+		*err = current.error;
+		free (heap);
+		return status;
+	}
+
+	intervalPush (heap, &size, current);
+	area = current.result;
+	errsum = current.error;
+
+	/* Bisect the interval with the largest error until the tolerance is met */
+	while (size < capacity) {
+		current = intervalRemove (heap, &size, 0);
+
+		left.a = current.a;
+		left.b = (current.a + current.b) / 2;
+		right.a = left.b;
+		right.b = current.b;
+
+		gaussKronrod (f, gk, left.a, left.b, &left.result, &left.error, &resabs, &defab1);
+		gaussKronrod (f, gk, right.a, right.b, &right.result, &right.error, &resabs, &defab2);
+		evaluations += 2 * rule;
+
+		area12 = left.result + right.result;
+		erro12 = left.error + right.error;
+		errsum += erro12 - current.error;
+		area += area12 - current.result;
+
+		/* Count bisections that don't improve the estimate, which means roundoff */
+		if (defab1 != left.error && defab2 != right.error) {
+			if (fabs (current.result - area12) <= 1e-5 * fabs (area12) && erro12 >= 0.99 * current.error) {
+				iroff1++;
 			}
 
-			p = (double)N * (z * p1 - p2) / (z * z - 1); //derivative of the Legendre Polynomial
-			z1 = z;
-			z = z1 - p1 / p;
+			if (size + 1 > 10 && erro12 > current.error) {
+				iroff2++;
+			}
 		}
 
-		/* Abscissas */
-		xi[i - 1] = -1 * z;
-		xi[N - i] = z;
+		intervalPush (heap, &size, left);
+		intervalPush (heap, &size, right);
 
-		/* Weights */
-		wi[i - 1] = 2.0 / ((1.0 - z * z) * (p * p));
-		wi[N - i] = wi[i - 1];
+		errbnd = fmax (epsAbs, epsRel * fabs (area));
+		if (errsum <= errbnd) {
+			break;
+		}
+
+		if (iroff1 >= 6 || iroff2 >= 20) {
+			status = INTEGRAL_ROUNDOFF;
+			break;
+		}
+
+		/* The interval is too small to bisect, so the integrand is badly behaved there */
+		if (fmax (fabs (left.a), fabs (right.b)) <= (1 + 100 * DBL_EPSILON) * (fabs (right.a) + 1000 * DBL_MIN)) {
+			status = INTEGRAL_BAD_INTEGRAND;
+			break;
+		}
 	}
 
-	/* Now we can apply the quadrature algorithm */
+	if (status == INTEGRAL_SUCCESS && errsum > errbnd) {
+		status = INTEGRAL_MAX_EVALUATIONS;
+	}
 
-	/* Set the starting value of the result to 0 */
-	*res = 0;
+	*res = intervalSum (heap, size);
+	*err = errsum;
 
-	/* The first step is to transform the bounds from [a,b] to [-1,1] */
-	mul1 = (b - a) / 2;
-	mul2 = mul1;
-	mul3 = (b + a) / 2;
+	free (heap);
 
-	/* Perform the integration */
-	for (i = 0; i < N; i++) {
-		x = mul2 * xi[i] + mul3;
-		fValue = f->function (x);
-		*res += wi[i] * fValue;
+	return status;
+}
+
+/* Adaptive integration of f from a to b with the rules evaluated in parallel.
+ *
+ * Each round takes the intervals with the largest errors off the heap, up to
+ * ADAPTIVE_PARALLEL_BATCH of them, as long as their errors are at least
+ * 1 / ADAPTIVE_PARALLEL_BATCH of the amount by which the total error is over
+ * the tolerance. Intervals that small would probably never be bisected by
+ * adaptiveIntegrate. The rules on both halves of every chosen interval are
+ * shared between the threads with dynamic scheduling, so a thread that
+ * finishes early takes the next rule. The results are then merged in the
+ * order the intervals were chosen, which makes the result independent of
+ * the number of threads and how the work was split.
+ * The arguments are the same as for adaptiveIntegrate */
+int
+adaptiveIntegrateParallel (adder_function *f, double a, double b, double epsAbs, double epsRel, int rule, long int maxEvaluations, double *res, double *err)
+{
+	const gauss_kronrod_rule *gk;
+	quad_interval *heap;
+	quad_interval *parents; /* Intervals bisected in the current round */
+	quad_interval *halves; /* Left and right halves of each parent */
+	double *defab; /* resasc of each half */
+	quad_interval current;
+	double area, errsum, errbnd;
+	double area12, erro12, excess;
+	double resabs, resasc;
+	int size = 0, capacity;
+	int count, i;
+	int iroff1 = 0, iroff2 = 0;
+	int tooSmall = 0;
+	int status = INTEGRAL_SUCCESS;
+
+	heap = adaptiveInit ("adaptiveIntegrateParallel", rule, epsAbs, epsRel, maxEvaluations, &gk, &capacity);
+	if (heap == NULL) {
+		return INTEGRAL_ERROR;
 	}
 
-	/* Multiply res by mul1 to get the final result */
-	*res *= mul1;
+	parents = malloc (ADAPTIVE_PARALLEL_BATCH * sizeof (quad_interval));
+	halves = malloc (2 * ADAPTIVE_PARALLEL_BATCH * sizeof (quad_interval));
+	defab = malloc (2 * ADAPTIVE_PARALLEL_BATCH * sizeof (double));
+	if (parents == NULL || halves == NULL || defab == NULL) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function adaptiveIntegrateParallel.\n");
+		free (heap);
+		free (parents);
+		free (halves);
+		free (defab);
+		return INTEGRAL_ERROR;
+	}
 
-	return INTEGRAL_SUCCESS;
+	/* First approximation to the integral */
+	current.a = a;
+	current.b = b;
+	gaussKronrod (f, gk, a, b, &current.result, &current.error, &resabs, &resasc);
+
+	errbnd = fmax (epsAbs, epsRel * fabs (current.result));
+	if (current.error <= 50 * DBL_EPSILON * resabs && current.error > errbnd) {
+		status = INTEGRAL_ROUNDOFF;
+	}
+	else if (capacity == 1 && current.error > errbnd) {
+		status = INTEGRAL_MAX_EVALUATIONS;
+	}
+
+	if (status != INTEGRAL_SUCCESS || (current.error <= errbnd && current.error != resasc) || current.error == 0) {
+		*res = current.result;
+		*err = current.error;
+		free (heap);
+		free (parents);
+		free (halves);
+		free (defab);
+		return status;
+	}
+
+	intervalPush (heap, &size, current);
+	area = current.result;
+	errsum = current.error;
+
+	do {
+		/* Choose the intervals for this round. Each bisection adds one interval */
+		excess = errsum - errbnd;
+		count = 0;
+		while (size > 0 && size + 2 * count < capacity && count < ADAPTIVE_PARALLEL_BATCH) {
+			if (count > 0 && heap[0].error < excess / ADAPTIVE_PARALLEL_BATCH) {
+				break;
+			}
+
+			parents[count++] = intervalRemove (heap, &size, 0);
+		}
+
+		if (count == 0) {
+			break;
+		}
+
+		#pragma omp parallel for schedule(dynamic, 1) private(resabs) if (count > 1)
+		for (i = 0; i < 2 * count; i++) {
+			const quad_interval *parent = &parents[i / 2];
+			const double mid = (parent->a + parent->b) / 2;
+
+			halves[i].a = (i % 2 == 0) ? parent->a : mid;
+			halves[i].b = (i % 2 == 0) ? mid : parent->b;
+			gaussKronrod (f, gk, halves[i].a, halves[i].b, &halves[i].result, &halves[i].error, &resabs, &defab[i]);
+		}
+
+		/* Merge the results in a fixed order */
+		for (i = 0; i < count; i++) {
+			area12 = halves[2 * i].result + halves[2 * i + 1].result;
+			erro12 = halves[2 * i].error + halves[2 * i + 1].error;
+			errsum += erro12 - parents[i].error;
+			area += area12 - parents[i].result;
+
+			if (defab[2 * i] != halves[2 * i].error && defab[2 * i + 1] != halves[2 * i + 1].error) {
+				if (fabs (parents[i].result - area12) <= 1e-5 * fabs (area12) && erro12 >= 0.99 * parents[i].error) {
+					iroff1++;
+				}
+
+				if (size + 1 > 10 && erro12 > parents[i].error) {
+					iroff2++;
+				}
+			}
+
+			intervalPush (heap, &size, halves[2 * i]);
+			intervalPush (heap, &size, halves[2 * i + 1]);
+
+			/* The interval is too small to bisect, so the integrand is badly behaved there */
+			if (fmax (fabs (halves[2 * i].a), fabs (halves[2 * i + 1].b)) <= (1 + 100 * DBL_EPSILON) * (fabs (halves[2 * i + 1].a) + 1000 * DBL_MIN)) {
+				tooSmall = 1;
+			}
+		}
+
+		errbnd = fmax (epsAbs, epsRel * fabs (area));
+		if (errsum > errbnd) {
+			if (iroff1 >= 6 || iroff2 >= 20) {
+				status = INTEGRAL_ROUNDOFF;
+			}
+			else if (tooSmall) {
+				status = INTEGRAL_BAD_INTEGRAND;
+			}
+		}
+	} while (status == INTEGRAL_SUCCESS && errsum > errbnd);
+
+	if (status == INTEGRAL_SUCCESS && errsum > errbnd) {
+		status = INTEGRAL_MAX_EVALUATIONS;
+	}
+
+	*res = intervalSum (heap, size);
+	*err = errsum;
+
+	free (heap);
+	free (parents);
+	free (halves);
+	free (defab);
+
+	return status;
+}
+
+/* Wynn's epsilon algorithm (QUADPACK's qelg). e holds the sequence of
+ * *n results, and the new diagonal of the epsilon table is calculated in
+ * place. result is the extrapolated limit and abserr its error estimate,
+ * which is based on the last three results in last3. nres counts calls. */
+static void
+wynnEpsilon (int *n, double *e, double *result, double *abserr, double *last3, int *nres)
+{
+	const int limexp = EPSILON_TABLE_SIZE - 2;
+	double res, e0, e1, e2, e3, e1abs;
+	double delta1, delta2, delta3;
+	double err1, err2, err3;
+	double tol1, tol2, tol3;
+	double ss, error;
+	int i, ib, ie, k1, k2, k3;
+	int newelm, num, indx;
+
+	/* Indices below are one-based as in QUADPACK, so element k is e[k - 1] */
+	(*nres)++;
+	*abserr = DBL_MAX;
+	*result = e[*n - 1];
+
+	if (*n < 3) {
+		*abserr = fmax (*abserr, 5 * DBL_EPSILON * fabs (*result));
+		return;
+	}
+
+	e[*n + 1] = e[*n - 1];
+	newelm = (*n - 1) / 2;
+	e[*n - 1] = DBL_MAX;
+	num = *n;
+	k1 = *n;
+
+	for (i = 1; i <= newelm; i++) {
+		k2 = k1 - 1;
+		k3 = k1 - 2;
+		res = e[k1 + 1];
+		e0 = e[k3 - 1];
+		e1 = e[k2 - 1];
+		e2 = res;
+		e1abs = fabs (e1);
+		delta2 = e2 - e1;
+		err2 = fabs (delta2);
+		tol2 = fmax (fabs (e2), e1abs) * DBL_EPSILON;
+		delta3 = e1 - e0;
+		err3 = fabs (delta3);
+		tol3 = fmax (e1abs, fabs (e0)) * DBL_EPSILON;
+
+		/* e0, e1, and e2 are equal to machine accuracy, so the sequence has converged */
+		if (err2 <= tol2 && err3 <= tol3) {
+			*result = res;
+			*abserr = fmax (err2 + err3, 5 * DBL_EPSILON * fabs (*result));
+			return;
+		}
+
+		e3 = e[k1 - 1];
+		e[k1 - 1] = e1;
+		delta1 = e1 - e3;
+		err1 = fabs (delta1);
+		tol1 = fmax (e1abs, fabs (e3)) * DBL_EPSILON;
+
+		/* Two elements are very close, so the table is cut off here */
+		if (err1 <= tol1 || err2 <= tol2 || err3 <= tol3) {
+			*n = i + i - 1;
+			break;
+		}
+
+		ss = 1 / delta1 + 1 / delta2 - 1 / delta3;
+
+		/* Irregular behavior in the table, so it's cut off here */
+		if (fabs (ss * e1) <= 1e-4) {
+			*n = i + i - 1;
+			break;
+		}
+
+		res = e1 + 1 / ss;
+		e[k1 - 1] = res;
+		k1 -= 2;
+		error = err2 + fabs (res - e2) + err3;
+
+		if (error <= *abserr) {
+			*abserr = error;
+			*result = res;
+		}
+	}
+
+	/* Shift the table */
+	if (*n == limexp) {
+		*n = 2 * (limexp / 2) - 1;
+	}
+
+	ib = (num % 2 == 0) ? 2 : 1;
+	ie = newelm + 1;
+	for (i = 1; i <= ie; i++) {
+		e[ib - 1] = e[ib + 1];
+		ib += 2;
+	}
+
+	if (num != *n) {
+		indx = num - *n + 1;
+		for (i = 1; i <= *n; i++) {
+			e[i - 1] = e[indx - 1];
+			indx++;
+		}
+	}
+
+	/* The error estimate compares the result with the last three results */
+	if (*nres < 4) {
+		last3[*nres - 1] = *result;
+		*abserr = DBL_MAX;
+	}
+	else {
+		*abserr = fabs (*result - last3[2]) + fabs (*result - last3[1]) + fabs (*result - last3[0]);
+		last3[0] = last3[1];
+		last3[1] = last3[2];
+		last3[2] = *result;
+	}
+
+	*abserr = fmax (*abserr, 5 * DBL_EPSILON * fabs (*result));
 }
 
+/* Return the index of the interval wider than small with the largest error, or -1 */
+static int
+largestWideInterval (quad_interval *heap, int size, double small)
+{
+	int i, best = -1;
+
+	for (i = 0; i < size; i++) {
+		if (fabs (heap[i].b - heap[i].a) > small && (best < 0 || heap[i].error > heap[best].error)) {
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/* Adaptive integration of f from a to b with extrapolation (QUADPACK's QAGS).
+ *
+ * The intervals are bisected as in adaptiveIntegrate. When the interval with
+ * the largest error is no wider than the current small width, the intervals
+ * wider than that are bisected until their total error is below the
+ * tolerance, and then the sum over all intervals is added to a sequence that
+ * is extrapolated with Wynn's epsilon algorithm. The small width is then
+ * halved. Near a singularity the sums converge like a geometric series, which
+ * the extrapolation accelerates.
+ * The arguments are the same as for adaptiveIntegrate */
+int
+adaptiveIntegrateSingular (adder_function *f, double a, double b, double epsAbs, double epsRel, int rule, long int maxEvaluations, double *res, double *err)
+{
+	const gauss_kronrod_rule *gk;
+	quad_interval *heap;
+	quad_interval current, left, right;
+	double epsTable[EPSILON_TABLE_SIZE];
+	double last3[3];
+	double area, errsum, errbnd, area12, erro12;
+	double erlast, erlarg = 0, ertest = 0, small = 0, correc = 0;
+	double result, abserr, reseps, abseps;
+	double defabs, resasc, resabs, defab1, defab2;
+	int size = 0, capacity;
+	int numEps, nres = 0, ktmin = 0;
+	int iroff1 = 0, iroff2 = 0, iroff3 = 0;
+	int ier = 0, ierro = 0;
+	int ksgn, extrap = 0, noext = 0;
+	int next;
+	int useSum = 0, checkDivergence;
+	static const int status[] = {INTEGRAL_SUCCESS, INTEGRAL_MAX_EVALUATIONS, INTEGRAL_ROUNDOFF, INTEGRAL_BAD_INTEGRAND, INTEGRAL_ROUNDOFF, INTEGRAL_DIVERGENT};
+
+	heap = adaptiveInit ("adaptiveIntegrateSingular", rule, epsAbs, epsRel, maxEvaluations, &gk, &capacity);
+	if (heap == NULL) {
+		return INTEGRAL_ERROR;
+	}
+
+	/* First approximation to the integral. The error codes in ier follow
+	 * QUADPACK's numbering until the end */
+	current.a = a;
+	current.b = b;
+	gaussKronrod (f, gk, a, b, &result, &abserr, &defabs, &resasc);
+	current.result = result;
+	current.error = abserr;
+
+	errbnd = fmax (epsAbs, epsRel * fabs (result));
+	if (abserr <= 100 * DBL_EPSILON * defabs && abserr > errbnd) {
+		ier = 2;
+	}
+
+	if (capacity == 1) {
+		ier = 1;
+	}
+
+	if (ier != 0 || (abserr <= errbnd && abserr != resasc) || abserr == 0) {
+		*res = result;
+		*err = abserr;
+		free (heap);
+		return (ier != 0 && abserr > errbnd) ? status[ier] : INTEGRAL_SUCCESS;
+	}
+
+	intervalPush (heap, &size, current);
+	epsTable[0] = result;
+	numEps = 2;
+	area = result;
+	errsum = abserr;
+	abserr = DBL_MAX;
+	ksgn = (fabs (result) >= (1 - 50 * DBL_EPSILON) * defabs) ? 1 : -1;
+
+	for (;;) {
+		/* While extrapolating, only intervals wider than small are bisected */
+		next = extrap ? largestWideInterval (heap, size, small) : 0;
+		current = intervalRemove (heap, &size, next < 0 ? 0 : next);
+		erlast = current.error;
+
+		left.a = current.a;
+		left.b = (current.a + current.b) / 2;
+		right.a = left.b;
+		right.b = current.b;
+
+		gaussKronrod (f, gk, left.a, left.b, &left.result, &left.error, &resabs, &defab1);
+		gaussKronrod (f, gk, right.a, right.b, &right.result, &right.error, &resabs, &defab2);
+
+		area12 = left.result + right.result;
+		erro12 = left.error + right.error;
+		errsum += erro12 - current.error;
+		area += area12 - current.result;
+
+		if (defab1 != left.error && defab2 != right.error) {
+			if (fabs (current.result - area12) <= 1e-5 * fabs (area12) && erro12 >= 0.99 * current.error) {
+				if (extrap) {
+					iroff2++;
+				}
+				else {
+					iroff1++;
+				}
+			}
+
+			if (size + 1 > 10 && erro12 > current.error) {
+				iroff3++;
+			}
+		}
+
+		intervalPush (heap, &size, left);
+		intervalPush (heap, &size, right);
+		errbnd = fmax (epsAbs, epsRel * fabs (area));
+
+		if (iroff1 + iroff2 >= 10 || iroff3 >= 20) {
+			ier = 2;
+		}
+
+		if (iroff2 >= 5) {
+			ierro = 3;
+		}
+
+		if (size == capacity) {
+			ier = 1;
+		}
+
+		if (fmax (fabs (left.a), fabs (right.b)) <= (1 + 100 * DBL_EPSILON) * (fabs (right.a) + 1000 * DBL_MIN)) {
+			ier = 4;
+		}
+
+		if (errsum <= errbnd) {
+			useSum = 1;
+			break;
+		}
+
+		if (ier != 0) {
+			break;
+		}
+
+		if (size == 2) {
+			small = fabs (b - a) * 0.375;
+			erlarg = errsum;
+			ertest = errbnd;
+			epsTable[1] = area;
+			continue;
+		}
+
+		if (noext) {
+			continue;
+		}
+
+		/* erlarg is the error over the intervals wider than small */
+		erlarg -= erlast;
+		if (fabs (left.b - left.a) > small) {
+			erlarg += erro12;
+		}
+
+		if (!extrap) {
+			/* Keep bisecting until the largest error is on a small interval */
+			if (fabs (heap[0].b - heap[0].a) > small) {
+				continue;
+			}
+
+			extrap = 1;
+		}
+
+		/* Reduce the error over the wide intervals before extrapolating */
+		if (ierro != 3 && erlarg > ertest && largestWideInterval (heap, size, small) >= 0) {
+			continue;
+		}
+
+		/* Extrapolate */
+		epsTable[numEps++] = area;
+		wynnEpsilon (&numEps, epsTable, &reseps, &abseps, last3, &nres);
+		ktmin++;
+
+		if (ktmin > 5 && abserr < 1e-3 * errsum) {
+			ier = 5;
+		}
+
+		if (abseps < abserr) {
+			ktmin = 0;
+			abserr = abseps;
+			result = reseps;
+			correc = erlarg;
+			ertest = fmax (epsAbs, epsRel * fabs (reseps));
+			if (abserr <= ertest) {
+				break;
+			}
+		}
+
+		/* The table has been cut back to one element, so stop extrapolating */
+		if (numEps == 1) {
+			noext = 1;
+		}
+
+		if (ier == 5) {
+			break;
+		}
+
+		extrap = 0;
+		small *= 0.5;
+		erlarg = errsum;
+	}
+
+	/* Choose between the extrapolated result and the sum over the intervals */
+	if (!useSum) {
+		checkDivergence = 1;
+
+		if (abserr == DBL_MAX) {
+			useSum = 1;
+		}
+		else if (ier + ierro != 0) {
+			if (ierro == 3) {
+				abserr += correc;
+			}
+
+			if (ier == 0) {
+				ier = 3;
+			}
+
+			if (result != 0 && area != 0) {
+				useSum = abserr / fabs (result) > errsum / fabs (area);
+			}
+			else if (abserr > errsum) {
+				useSum = 1;
+			}
+			else if (area == 0) {
+				checkDivergence = 0;
+			}
+		}
+
+		if (ksgn == -1 && fmax (fabs (result), fabs (area)) <= defabs * 0.01) {
+			checkDivergence = 0;
+		}
+
+		/* The integral is probably divergent if the two disagree */
+		if (!useSum && checkDivergence) {
+			if (0.01 > result / area || result / area > 100 || errsum > fabs (area)) {
+				ier = 6;
+			}
+		}
+	}
+
+	if (useSum) {
+		result = intervalSum (heap, size);
+		abserr = errsum;
+	}
+
+	if (ier > 2) {
+		ier--;
+	}
+
+	*res = result;
+	*err = abserr;
+
+	free (heap);
+
+	return status[ier];
+}
 
 /******************************
  * Other integration routines *
  ******************************/
 
+/* Evaluate an adder_function at every point of a batch */
+static void
+scalarBatch (const double *x, double *y, size_t n, void *data)
+{
+	adder_function *f = data;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		y[i] = evaluateFunction (f, x[i]);
+	}
+}
+
 /* Apply the Trapezoidal Rule
  * f is the function being integrated
  * a is the lower bound of integration
  * b is the upper bound of integration
- * N is the number of points to use */
+ * N is the number of intervals, so f is evaluated at N + 1 points */
 double
 trapezoidIntegrate (adder_function *f, double a, double b, int N)
 {
+	adder_batch_function batch = {scalarBatch, f};
+
+	return trapezoidIntegrateBatch (&batch, a, b, N);
+}
+
+/* Apply the Trapezoidal Rule to a batch function.
+ * The arguments are the same as for trapezoidIntegrate */
+double
+trapezoidIntegrateBatch (adder_batch_function *f, double a, double b, int N)
+{
+	double *x, *y;
 	double dX;
-	double x;
-	double points[N];
 	double res = 0;
-	int i;
+	int start, count;
+	int i, k;
 
-	dX = (b - a) / (double)N;
+	if (N < 1) {
+		fprintf (stderr, "ERROR:  Invalid number of intervals in function trapezoidIntegrateBatch.\n");
+		return NAN;
+	}
 
-	/* Calculate the points that form the edges of the intervals */
-	for (i = 0; i < N; i++) {
-		x = a + i * dX;
-		points[i] = f->function (x);
+	x = malloc (2 * INTEGRATION_BATCH * sizeof (double));
+	if (x == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function trapezoidIntegrateBatch.\n");
+		return NAN;
 	}
 
-	/* Perform the integration */
-	for (i = 0; i <= N; i++) {
-		if (i == 0 || i == N) {
-			res += points[i];
+	y = x + INTEGRATION_BATCH;
+	dX = (b - a) / (double)N;
+
+	/* Evaluate the N + 1 edges of the intervals a batch at a time. The
+	 * first and last points have weight 1/2 */
+	for (start = 0; start <= N; start += count) {
+		count = N + 1 - start < INTEGRATION_BATCH ? N + 1 - start : INTEGRATION_BATCH;
+
+		for (i = 0; i < count; i++) {
+			k = start + i;
+			x[i] = k == N ? b : a + k * dX;
 		}
-		else {
-			res += 2 * points[i];
+
+		f->function (x, y, count, f->data);
+
+		for (i = 0; i < count; i++) {
+			k = start + i;
+			res += (k == 0 || k == N) ? y[i] / 2 : y[i];
 		}
 	}
 
-	res *= dX / 2;
-	return res;
+	free (x);
+
+	return res * dX;
 }
 
 /* Apply the Composite Simpson's Rule
  * f is the function being integrated
  * a is the lower bound of integration
  * b is the upper bound of integration
- * N is the number of points to use.
- * NOTE:  n must be an even number */
+ * N is the number of intervals, so f is evaluated at N + 1 points.
+ * NOTE:  N must be an even number */
 double
 simpsonIntegrate (adder_function *f, double a, double b, int N)
 {
+	adder_batch_function batch = {scalarBatch, f};
+
+	return simpsonIntegrateBatch (&batch, a, b, N);
+}
+
+/* Apply the Composite Simpson's Rule to a batch function.
+ * The arguments are the same as for simpsonIntegrate */
+double
+simpsonIntegrateBatch (adder_batch_function *f, double a, double b, int N)
+{
+	double *x, *y;
 	double dx;
-	double x;
-	double points[N];
 	double res = 0;
-	int i;
-
-	/* Create the points array */
-//	points = malloc (N * sizeof (double));
-//	if (points
+	int start, count;
+	int i, k;
 
-	/* Calculate the constants */
-	dx = (b - a) / (double)N;
+	if (N < 2 || N % 2 != 0) {
+		fprintf (stderr, "ERROR:  Number of intervals must be even in function simpsonIntegrateBatch.\n");
+		return NAN;
+	}
 
-	/* Calculate the function values for each point */
-	for (i = 0; i < N; i++) {
-		x = a + i * dx;
-		points[i] = f->function (x);
+	x = malloc (2 * INTEGRATION_BATCH * sizeof (double));
+	if (x == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function simpsonIntegrateBatch.\n");
+		return NAN;
 	}
 
-	/* Calculate the first and last points */
-	res += points[0];
-	res += points[N - 1];
+	y = x + INTEGRATION_BATCH;
+	dx = (b - a) / (double)N;
+
+	/* Evaluate the N + 1 points a batch at a time. The first and last points
+	 * have weight 1, the others alternate between 4 and 2 */
+	for (start = 0; start <= N; start += count) {
+		count = N + 1 - start < INTEGRATION_BATCH ? N + 1 - start : INTEGRATION_BATCH;
 
-	/* Iterate the rest of the algorithm */
-	for (i = 1; i < N - 1; i++) {
-		if (i % 2 == 0) {
-			res += 2 * points[i];
+		for (i = 0; i < count; i++) {
+			k = start + i;
+			x[i] = k == N ? b : a + k * dx;
 		}
-		else {
-			res += 4 * points[i];
+
+		f->function (x, y, count, f->data);
+
+		for (i = 0; i < count; i++) {
+			k = start + i;
+			if (k == 0 || k == N) {
+				res += y[i];
+			}
+			else {
+				res += (k % 2 == 1) ? 4 * y[i] : 2 * y[i];
+			}
 		}
 	}
 
-	/* Multiply the sum by dx/3 to get the final result */
-	res *= dx / 3;
+	free (x);
 
-	return res;
+	/* Multiply the sum by dx/3 to get the final result */
+	return res * dx / 3;
 }
 
-/* Monte Carlo integration. /dev/urandom is used as a random seed with system time used
- * as a fallback in case reading fails. The generator used is Xorshift. */
-double
-monteCarloIntegrate (adder_function *f, double a, double b, long unsigned int N)
+/* Seed for Monte Carlo integration. /dev/urandom is used with the
+ * system time as a fallback in case reading fails */
+static long unsigned int
+monteCarloSeed ()
 {
-	long unsigned int v;
-	double x, y;
-	double mul1, mul2;
-	double result = 0;
-	int i;
-	int err = 0;
+	long unsigned int v = 0;
 	FILE *fp;
 
 	fp = fopen ("/dev/urandom", "r");
-	if (fp == 0) {
-		err = 1;
-	}
-
-	/* If fopen succeeded then read from /dev/urandom */
-	if (err == 0) {
-		err = fread (&v, sizeof (long unsigned int), 1, fp);
-
-		/* If reading failed then fall back to using the system time */
-		if (err == 0) {
-			fclose (fp);
-			v = time (NULL);
+	if (fp != 0x00) {
+		if (fread (&v, sizeof (long unsigned int), 1, fp) != 1) {
+			v = 0;
 		}
 
 		fclose (fp);
 	}
 
-	/* Otherwise use the system time as the seed */
-	else {
-		fclose (fp);
-
+	/* Xorshift needs a nonzero state */
+	if (v == 0) {
 		v = time (NULL);
 	}
 
-	/* Change the bounds of integration to be between 0 and 1 */
-	mul1 = (a - b) / (0 - 1);
-	mul2 = a - 0 * ((a - b) / (0 - 1));
+	return v;
+}
 
-	for (i = 0; i < N; i++) {
-		/* Generate a number between 0 and 1 using the Xorshift generator */
-		v = xorshift (v);
-		x = (double)v / (double)0xffffffffffffffff;
-		x = x * mul1 + mul2;
+/* Monte Carlo integration. The generator used is Xorshift. */
+double
+monteCarloIntegrate (adder_function *f, double a, double b, long unsigned int N)
+{
+	adder_batch_function batch = {scalarBatch, f};
 
-		y = f->function (x);
-		y *= (b - a);
+	return monteCarloIntegrateBatch (&batch, a, b, N);
+}
 
-		result += y;
+/* Monte Carlo integration of a batch function. The points are generated
+ * and passed to f MONTE_CARLO_BATCH at a time */
+double
+monteCarloIntegrateBatch (adder_batch_function *f, double a, double b, long unsigned int N)
+{
+	long unsigned int v;
+	long unsigned int done;
+	double *x, *y;
+	double result = 0;
+	size_t count, i;
+
+	if (N == 0) {
+		fprintf (stderr, "ERROR:  Invalid number of points in function monteCarloIntegrateBatch.\n");
+		return NAN;
+	}
+
+	x = malloc (2 * MONTE_CARLO_BATCH * sizeof (double));
+	if (x == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function monteCarloIntegrateBatch.\n");
+		return NAN;
+	}
+
+	y = x + MONTE_CARLO_BATCH;
+	v = monteCarloSeed ();
+
+	for (done = 0; done < N; done += count) {
+		count = (N - done < MONTE_CARLO_BATCH) ? N - done : MONTE_CARLO_BATCH;
+
+		/* Generate numbers between 0 and 1 using the Xorshift generator
+		 * and change them to be between a and b */
+		for (i = 0; i < count; i++) {
+			v = xorshift (v);
+			x[i] = a + (b - a) * ((double)v / (double)0xffffffffffffffff);
+		}
+
+		f->function (x, y, count, f->data);
+
+		for (i = 0; i < count; i++) {
+			result += y[i];
+		}
 	}
 
-	result /= (double)N;
+	free (x);
 
-	return result;
+	return result * (b - a) / (double)N;
 }
 
 /* Xorshift generator for Monte Carlo integration, which has better
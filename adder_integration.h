@@ -12,9 +12,45 @@ enum
 IntegralErrors
 {
 	INTEGRAL_SUCCESS,
-	INTEGRAL_ERROR
+	INTEGRAL_ERROR,
+	INTEGRAL_MAX_EVALUATIONS, /* The evaluation budget ran out before the tolerance was met */
+	INTEGRAL_ROUNDOFF, /* Roundoff error keeps the tolerance from being met */
+	INTEGRAL_BAD_INTEGRAND, /* The integrand is too irregular somewhere in the interval */
+	INTEGRAL_DIVERGENT /* The integral is probably divergent or converges too slowly */
 };
 
+/* Gauss-Kronrod rules for adaptive integration. The Gauss rule with n
+ * points is extended to 2n + 1 points and the difference between the
+ * two gives the error estimate */
+enum
+GaussKronrodRules
+{
+	GAUSS_KRONROD_15 = 15, /* 7 point Gauss, 15 point Kronrod */
+	GAUSS_KRONROD_21 = 21 /* 10 point Gauss, 21 point Kronrod */
+};
+
+/* Gauss-Legendre rule type definition.
+ * A rule integrates polynomials up to degree 2n - 1 exactly on [-1, 1] */
+typedef struct
+{
+	int n; /* Number of points */
+	double *nodes; /* Abscissas in increasing order */
+	double *weights; /* Weights */
+} adder_gauss_rule;
+
+/* Rules with at least this many points are generated with an asymptotic
+ * expansion in O(n) time instead of Newton's method on the recurrence,
+ * which takes O(n^2) */
+#define GAUSS_ASYMPTOTIC_SIZE 1000
+
+/* Gauss-Legendre rules. Rules returned by gaussRuleCached are shared
+ * and must not be deleted */
+adder_gauss_rule * gaussRuleInit (int N);
+void deleteGaussRule (adder_gauss_rule *rule);
+adder_gauss_rule * gaussRuleCached (int N);
+void gaussRuleCacheClear ();
+double gaussRuleIntegrate (adder_gauss_rule *rule, adder_function *f, double a, double b);
+
 /* Gauss-Legendre quadrature */
 double gauss3 (adder_function *f, double a, double b);
 double gauss5 (adder_function *f, double a, double b);
@@ -23,11 +59,46 @@ double gauss50 (adder_function *f, double a, double b);
 double gauss100 (adder_function *f, double a, double b);
 int galeQuad (adder_function *f, double *res, double a, double b, int N);
 
+/* Adaptive integration. The interval with the largest error is bisected
+ * until the error estimate err is at most max (epsAbs, epsRel * |res|) or
+ * maxEvaluations function evaluations have been used. res and err are set
+ * even if the tolerance isn't met, and the return value says why.
+ * adaptiveIntegrateSingular also extrapolates the sequence of results with
+ * Wynn's epsilon algorithm, which handles integrable singularities at the
+ * ends and inside the interval. These follow QAG and QAGS from QUADPACK. */
+int adaptiveIntegrate (adder_function *f, double a, double b, double epsAbs, double epsRel, int rule, long int maxEvaluations, double *res, double *err);
+int adaptiveIntegrateSingular (adder_function *f, double a, double b, double epsAbs, double epsRel, int rule, long int maxEvaluations, double *res, double *err);
+
+/* Largest number of intervals bisected together by adaptiveIntegrateParallel */
+#define ADAPTIVE_PARALLEL_BATCH 64
+
+/* Adaptive integration for expensive integrands, with the function
+ * evaluated by several threads at once, so f must be safe to call from
+ * multiple threads. The arguments are the same as for adaptiveIntegrate.
+ * The intervals to bisect are chosen in rounds that don't depend on the
+ * number of threads, and the results are added in a fixed order, so res
+ * and err are the same for any number of threads. */
+int adaptiveIntegrateParallel (adder_function *f, double a, double b, double epsAbs, double epsRel, int rule, long int maxEvaluations, double *res, double *err);
+
 /*Other integration routines */
 double trapezoidIntegrate (adder_function *f, double a, double b, int N);
 double simpsonIntegrate (adder_function *f, double a, double b, int N);
 double monteCarloIntegrate (adder_function *f, double a, double b, long unsigned int N);
 
+/* Integration of batch functions. All points of a Gauss-Legendre rule are
+ * passed to f in one call. Trapezoid and Simpson points are passed
+ * INTEGRATION_BATCH at a time and Monte Carlo points MONTE_CARLO_BATCH at a
+ * time, so the workspace doesn't grow with N. The double functions return
+ * NaN if the arguments are invalid or memory can't be allocated */
+#define INTEGRATION_BATCH 4096
+#define MONTE_CARLO_BATCH 4096
+
+double gaussRuleIntegrateBatch (adder_gauss_rule *rule, adder_batch_function *f, double a, double b);
+int galeQuadBatch (adder_batch_function *f, double *res, double a, double b, int N);
+double trapezoidIntegrateBatch (adder_batch_function *f, double a, double b, int N);
+double simpsonIntegrateBatch (adder_batch_function *f, double a, double b, int N);
+double monteCarloIntegrateBatch (adder_batch_function *f, double a, double b, long unsigned int N);
+
 /* Other routines */
 long unsigned int xorshift (long unsigned int y);
 
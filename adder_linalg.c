@@ -3,12 +3,16 @@
  * This is the linear algebra part of Adder */
 #include <stdlib.h> /* For malloc and free */
 #include <string.h> /* For memcpy */
-#include <math.h> /* For fabs */
+#include <math.h> /* For fabs, sqrt, and hypot */
 #include <cblas.h>
 #include <lapacke.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "adder_math.h"
 #include "adder_matrix.h"
 #include "adder_linalg.h"
+#include "adder_qr.h" /* For tsqrLeastSquares */
 
 #define max(x, y) x >= y ? x : y
 
@@ -322,6 +326,112 @@ pseudoinverse (adder_matrix *m)
 	return res;
 }
 
+/*********************
+ * LU factorization *
+ *********************/
+
+/* Calculate the LU factorization of a square matrix.
+ * The factorization can be reused to solve for many right-side vectors
+ * and to estimate the condition number. M is not overwritten. */
+adder_lu *
+luInit (adder_matrix *M)
+{
+	adder_lu *lu;
+	lapack_int err;
+	int n;
+
+	/* The matrix has to be square */
+	if (M->rows != M->columns) {
+		fprintf (stderr, "Dimension error:  Matrix not square.\n");
+		return NULL;
+	}
+
+	n = M->rows;
+
+	lu = malloc (sizeof (adder_lu));
+	if (lu == 0x00) {
+		fprintf (stderr, "Failed to create LU factorization.\n");
+		return NULL;
+	}
+
+	lu->LU = malloc (n * n * sizeof (double));
+	if (lu->LU == 0x00) {
+		fprintf (stderr, "Failed to create LU factorization.\n");
+		free (lu);
+		return NULL;
+	}
+
+	lu->ipvt = malloc (n * sizeof (int));
+	if (lu->ipvt == 0x00) {
+		fprintf (stderr, "Failed to create LU factorization.\n");
+		free (lu->LU);
+		free (lu);
+		return NULL;
+	}
+
+	memcpy (lu->LU, M->mat, n * n * sizeof (double));
+	lu->n = n;
+
+	/* The 1-norm has to be calculated before the matrix is factored */
+	lu->anorm = matrixNorm1 (M);
+
+	err = LAPACKE_dgetrf (LAPACK_ROW_MAJOR, n, n, lu->LU, n, lu->ipvt);
+	if (err < 0) {
+		fprintf (stderr, "The value of argument %d is illegal\n", -1 * err);
+		deleteLU (lu);
+		return NULL;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "Factorization is singular.\n");
+		deleteLU (lu);
+		return NULL;
+	}
+
+	return lu;
+}
+
+/* Delete an LU factorization */
+void
+deleteLU (adder_lu *lu)
+{
+	free (lu->LU);
+	free (lu->ipvt);
+	free (lu);
+}
+
+/* Solve the linear system M * x = b using the LU factorization of M */
+adder_vector *
+luSolve (adder_lu *lu, adder_vector *b)
+{
+	adder_vector *res;
+	lapack_int err;
+
+	/* Check that b is a column vector with the right size */
+	if (b->orientation == ROW_VECTOR) {
+		fprintf (stderr, "ERROR:  b vector must be a column vector.\n");
+		return NULL;
+	}
+
+	if (b->size != lu->n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function luSolve.\n");
+		return NULL;
+	}
+
+	res = vectorInit (COLUMN_VECTOR, b->size, b->vect);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	err = LAPACKE_dgetrs (LAPACK_ROW_MAJOR, 'N', lu->n, 1, lu->LU, lu->n, lu->ipvt, res->vect, 1);
+	if (err != 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		deleteVector (res);
+		return NULL;
+	}
+
+	return res;
+}
+
 /********************
  * Equation solving *
  ********************/
@@ -462,10 +572,272 @@ linearLeastSquares (adder_matrix *M, adder_vector *b)
 	}
 }
 
+/* Generate a pseudo-random number from a counter using the SplitMix64 generator.
+ * Using a counter instead of a running state means every row of the sketch
+ * can be generated independently, so the result doesn't depend on the number of threads. */
+static unsigned long int
+splitmix64 (unsigned long int x)
+{
+	x += 0x9e3779b97f4a7c15;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+
+	return x ^ (x >> 31);
+}
+
+/* Solve an overdetermined least squares problem using a randomized preconditioner.
+ * tol is the relative tolerance for LSQR
+ * iterLimit is the maximum number of LSQR iterations
+ *
+ * This is the sketch-and-precondition method used by Blendenpik. The system is
+ * first compressed to 4n rows with a sparse sign embedding, which adds each row
+ * of [M b] with random signs to a few random rows of the sketch. The QR
+ * factorization of the sketch gives a triangular R such that M * R^-1 is well
+ * conditioned no matter how ill-conditioned M is, so LSQR applied to it converges
+ * in a few dozen iterations. The sketch solution is used as the starting point.
+ * The cost is O(nnz(M)) for the sketch, O(n^3) for the small QR, and two
+ * matrix-vector products per iteration, compared to O(m * n^2) for a dense QR.
+ * M and b are not overwritten. */
+adder_vector *
+sketchLeastSquares (adder_matrix *M, adder_vector *b, double tol, int iterLimit)
+{
+	const int m = M->rows;
+	const int n = M->columns;
+	const int nnzPerRow = 8; /* Number of nonzeros in each column of the sketching matrix */
+	const unsigned long int seed = 0x5eed;
+	adder_vector *res;
+	double *SA; /* Sketch of M, which is replaced by its QR factorization */
+	double *Sb; /* Sketch of b */
+	double *tau;
+	double *r, *u, *v, *w, *t, *y;
+	double alpha, beta;
+	double rho, rhoBar;
+	double phi, phiBar;
+	double c, s, theta;
+	double anorm = 0;
+	double scale;
+	int d;
+	int i, j, k;
+	int iter;
+	lapack_int err;
+
+	/* Check the dimensions of the system */
+	if (M->rows != b->size) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function sketchLeastSquares.\n");
+		return 0x00;
+	}
+
+	/* The sketch has four times as many rows as M has columns. If that isn't
+	 * much smaller than M then sketching doesn't save anything */
+	d = 4 * n;
+	if (m < 2 * d) {
+		return tsqrLeastSquares (M, b, 1);
+	}
+
+	SA = calloc ((long int)d * n, sizeof (double));
+	Sb = calloc (d, sizeof (double));
+	tau = malloc (n * sizeof (double));
+	r = malloc (m * sizeof (double));
+	u = malloc (m * sizeof (double));
+	v = malloc (n * sizeof (double));
+	w = malloc (n * sizeof (double));
+	t = malloc (n * sizeof (double));
+	y = calloc (n, sizeof (double));
+
+	res = vectorInit2 (COLUMN_VECTOR, n);
+
+	if (SA == 0x00 || Sb == 0x00 || tau == 0x00 || r == 0x00 || u == 0x00 || v == 0x00 || w == 0x00 || t == 0x00 || y == 0x00 || res == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function sketchLeastSquares.\n");
+		free (SA);
+		free (Sb);
+		free (tau);
+		free (r);
+		free (u);
+		free (v);
+		free (w);
+		free (t);
+		free (y);
+		if (res != 0x00) {
+			deleteVector (res);
+		}
+
+		return 0x00;
+	}
+
+	/* Create the sketch. Each row of [M b] is added to nnzPerRow rows of the
+	 * sketch with random signs. The rows of the sketch are split between the
+	 * threads, and each thread goes through all rows of M and only adds the
+	 * ones that land in its part. Every row of the sketch is then summed in
+	 * the same order for any number of threads, and no thread needs a
+	 * private copy of the sketch */
+	scale = 1 / sqrt ((double)nnzPerRow);
+
+	#pragma omp parallel private(i, j, k)
+	{
+		unsigned long int rnd;
+		double sgn;
+		int row;
+		int first = 0;
+		int last = d;
+
+#ifdef _OPENMP
+		first = (int)((long int)d * omp_get_thread_num () / omp_get_num_threads ());
+		last = (int)((long int)d * (omp_get_thread_num () + 1) / omp_get_num_threads ());
+#endif
+
+		for (i = 0; i < m; i++) {
+			for (k = 0; k < nnzPerRow; k++) {
+				rnd = splitmix64 (seed + (unsigned long int)i * nnzPerRow + k);
+				row = (int)((rnd >> 1) % d);
+				if (row < first || row >= last) {
+					continue;
+				}
+
+				sgn = (rnd & 1) ? scale : -scale;
+
+				for (j = 0; j < n; j++) {
+					SA[row * n + j] += sgn * M->mat[(long int)i * n + j];
+				}
+
+				Sb[row] += sgn * b->vect[i];
+			}
+		}
+	}
+
+	/* The triangular factor of the sketch is the preconditioner */
+	err = LAPACKE_dgeqrf (LAPACK_ROW_MAJOR, d, n, SA, n, tau);
+	if (err == 0) {
+		err = LAPACKE_dormqr (LAPACK_ROW_MAJOR, 'L', 'T', d, 1, n, SA, n, tau, Sb, 1);
+	}
+
+	if (err != 0) {
+		fprintf (stderr, "ERROR:  Failed to factor the sketch in function sketchLeastSquares.\n");
+		iterLimit = -1;
+	}
+
+	/* If the sketch is rank deficient then so is M, and the
+	 * preconditioner can't be used */
+	for (i = 0; i < n && iterLimit >= 0; i++) {
+		if (fabs (SA[i * n + i]) <= __DBL_EPSILON__ * fabs (SA[0])) {
+			fprintf (stderr, "ERROR:  Matrix is rank deficient in function sketchLeastSquares.\n");
+			iterLimit = -1;
+		}
+	}
+
+	if (iterLimit < 0) {
+		free (SA);
+		free (Sb);
+		free (tau);
+		free (r);
+		free (u);
+		free (v);
+		free (w);
+		free (t);
+		free (y);
+		deleteVector (res);
+		return 0x00;
+	}
+
+	/* Start from the solution of the sketched problem, x0 = R^-1 * Q' * Sb */
+	memcpy (res->vect, Sb, n * sizeof (double));
+	cblas_dtrsv (CblasRowMajor, CblasUpper, CblasNoTrans, CblasNonUnit, n, SA, n, res->vect, 1);
+
+	/* r = b - M * x0 */
+	memcpy (r, b->vect, m * sizeof (double));
+	cblas_dgemv (CblasRowMajor, CblasNoTrans, m, n, -1.0, M->mat, n, res->vect, 1, 1.0, r, 1);
+
+	/* Use LSQR to solve min || M * R^-1 * y - r ||, so that x = x0 + R^-1 * y.
+	 * beta * u = r */
+	memcpy (u, r, m * sizeof (double));
+	beta = cblas_dnrm2 (m, u, 1);
+
+	if (beta > 0) {
+		cblas_dscal (m, 1 / beta, u, 1);
+
+		/* alpha * v = R^-T * M' * u */
+		cblas_dgemv (CblasRowMajor, CblasTrans, m, n, 1.0, M->mat, n, u, 1, 0.0, v, 1);
+		cblas_dtrsv (CblasRowMajor, CblasUpper, CblasTrans, CblasNonUnit, n, SA, n, v, 1);
+		alpha = cblas_dnrm2 (n, v, 1);
+	}
+	else {
+		alpha = 0;
+	}
+
+	if (alpha > 0) {
+		cblas_dscal (n, 1 / alpha, v, 1);
+	}
+
+	memcpy (w, v, n * sizeof (double));
+	phiBar = beta;
+	rhoBar = alpha;
+
+	for (iter = 0; iter < iterLimit && alpha > 0 && beta > 0; iter++) {
+		/* beta * u = M * R^-1 * v - alpha * u */
+		memcpy (t, v, n * sizeof (double));
+		cblas_dtrsv (CblasRowMajor, CblasUpper, CblasNoTrans, CblasNonUnit, n, SA, n, t, 1);
+		cblas_dgemv (CblasRowMajor, CblasNoTrans, m, n, 1.0, M->mat, n, t, 1, -alpha, u, 1);
+		beta = cblas_dnrm2 (m, u, 1);
+		anorm = sqrt (anorm * anorm + alpha * alpha + beta * beta);
+
+		if (beta > 0) {
+			cblas_dscal (m, 1 / beta, u, 1);
+
+			/* alpha * v = R^-T * M' * u - beta * v */
+			cblas_dgemv (CblasRowMajor, CblasTrans, m, n, 1.0, M->mat, n, u, 1, 0.0, t, 1);
+			cblas_dtrsv (CblasRowMajor, CblasUpper, CblasTrans, CblasNonUnit, n, SA, n, t, 1);
+			for (j = 0; j < n; j++) {
+				v[j] = t[j] - beta * v[j];
+			}
+
+			alpha = cblas_dnrm2 (n, v, 1);
+			if (alpha > 0) {
+				cblas_dscal (n, 1 / alpha, v, 1);
+			}
+		}
+
+		/* Apply the next plane rotation */
+		rho = hypot (rhoBar, beta);
+		c = rhoBar / rho;
+		s = beta / rho;
+		theta = s * alpha;
+		rhoBar = -c * alpha;
+		phi = c * phiBar;
+		phiBar = s * phiBar;
+
+		/* Update the solution and the search direction */
+		for (j = 0; j < n; j++) {
+			y[j] += (phi / rho) * w[j];
+			w[j] = v[j] - (theta / rho) * w[j];
+		}
+
+		/* Stop when || (M * R^-1)' * r || is small relative to || M * R^-1 || * || r || */
+		if (alpha * fabs (c) <= tol * anorm) {
+			break;
+		}
+	}
+
+	/* x = x0 + R^-1 * y */
+	cblas_dtrsv (CblasRowMajor, CblasUpper, CblasNoTrans, CblasNonUnit, n, SA, n, y, 1);
+	cblas_daxpy (n, 1.0, y, 1, res->vect, 1);
+
+	free (SA);
+	free (Sb);
+	free (tau);
+	free (r);
+	free (u);
+	free (v);
+	free (w);
+	free (t);
+	free (y);
+
+	return res;
+}
+
 /* Calculate the exponential curve to fit data using linearization.
  * The linearized equation is of the form ln(y) = ln(a) + bx = A + bx
  * The calculated equation is of the form y = a*e^(bx).
- * The coefficient are returned as a column vector of the form [a, b]'. */
+ * The coefficient are returned as a column vector of the form [a, b]'.
+ * M and b are not overwritten. */
 adder_vector *
 exponentialFit (adder_matrix *M, adder_vector *b)
 {
@@ -474,6 +846,7 @@ exponentialFit (adder_matrix *M, adder_vector *b)
 	int rank;
 	int err;
 	double temp;
+	adder_matrix *A;
 	adder_vector *res;
 	int i;
 
@@ -497,20 +870,29 @@ exponentialFit (adder_matrix *M, adder_vector *b)
 		return NULL;
 	}
 
-	/* Linearize the values in the right-side vector by taking the natural log of each value */
-	for (i = 0; i < b->size; i++) {
-		b->vect[i] = log (b->vect[i]);
+	/* Create a copy of M so it doesn't get overwritten by the factorization */
+	A = matrixInit (m, n, M->mat);
+	if (A == 0x00) {
+		free (pvt);
+		return NULL;
 	}
 
-	res = vectorInit (COLUMN_VECTOR, b->size, b->vect);
+	res = vectorInit2 (COLUMN_VECTOR, b->size);
 	if (res == 0x00) {
 		free (pvt);
+		deleteMatrix (A);
 		return NULL;
 	}
 
+	/* Linearize the values in the right-side vector by taking the natural log of each value */
+	for (i = 0; i < b->size; i++) {
+		res->vect[i] = log (b->vect[i]);
+	}
+
 	/* Calculate the coefficients using linear least squares.
 	 * res will be of the form res = [b a]' */
-	err = LAPACKE_dgelsy (LAPACK_ROW_MAJOR, m, n, 1, M->mat, n, res->vect, 1, pvt, 1e-8, &rank);
+	err = LAPACKE_dgelsy (LAPACK_ROW_MAJOR, m, n, 1, A->mat, n, res->vect, 1, pvt, 1e-8, &rank);
+	deleteMatrix (A);
 
 	if (err < 0) {
 		fprintf (stderr, "Failed to calculate the best-fit curve.\n");
@@ -539,7 +921,8 @@ exponentialFit (adder_matrix *M, adder_vector *b)
 
 /* Calculate the exponential curve to fit data using linearization.
  * The linearized equation is of the form ln(y) = ln(a) + b * ln(x) = A + b * X
- * The calculated equation is of the form y = a*x^b */
+ * The calculated equation is of the form y = a*x^b
+ * M and b are not overwritten. */
 adder_vector *
 powerFit (adder_matrix *M, adder_vector *b)
 {
@@ -548,6 +931,7 @@ powerFit (adder_matrix *M, adder_vector *b)
 	int rank;
 	int err;
 	double temp;
+	adder_matrix *A;
 	adder_vector *res;
 	int i;
 
@@ -571,22 +955,31 @@ powerFit (adder_matrix *M, adder_vector *b)
 		return NULL;
 	}
 
-	/* Linearize the values in the right-side vector and the first column of the matrix
-	 * by taking the natural log of each value. This gives the natural log of y and x. */
-	for (i = 0; i < b->size; i++) {
-		b->vect[i] = log (b->vect[i]);
-		M->mat[2 * i] = log (M->mat[2 * i]);
+	/* Create a copy of M so it doesn't get overwritten */
+	A = matrixInit (m, n, M->mat);
+	if (A == 0x00) {
+		free (pvt);
+		return NULL;
 	}
 
-	res = vectorInit (COLUMN_VECTOR, b->size, b->vect);
+	res = vectorInit2 (COLUMN_VECTOR, b->size);
 	if (res == 0x00) {
 		free (pvt);
+		deleteMatrix (A);
 		return NULL;
 	}
 
+	/* Linearize the values in the right-side vector and the first column of the matrix
+	 * by taking the natural log of each value. This gives the natural log of y and x. */
+	for (i = 0; i < b->size; i++) {
+		res->vect[i] = log (b->vect[i]);
+		A->mat[n * i] = log (A->mat[n * i]);
+	}
+
 	/* Calculate the coefficients using linear least squares.
 	 * res will be of the form res = [b a]' */
-	err = LAPACKE_dgelsy (LAPACK_ROW_MAJOR, m, n, 1, M->mat, n, res->vect, 1, pvt, 1e-8, &rank);
+	err = LAPACKE_dgelsy (LAPACK_ROW_MAJOR, m, n, 1, A->mat, n, res->vect, 1, pvt, 1e-8, &rank);
+	deleteMatrix (A);
 
 	if (err < 0) {
 		fprintf (stderr, "Failed to calculate the best-fit curve.\n");
@@ -613,6 +1006,173 @@ powerFit (adder_matrix *M, adder_vector *b)
 	return res;
 }
 
+/* Fit y = exp (A + b * u) to every row of Y using least squares on ln(y).
+ * u is x for exponential fits and ln(x) for power fits.
+ * This is the shared part of exponentialFitBatch and powerFitBatch. */
+static int
+logLinearFitBatch (adder_matrix *X, adder_matrix *Y, adder_matrix *coefficients, adder_matrix *residuals, int logX, const char *name)
+{
+	const int numSeries = Y->rows;
+	const int numPoints = Y->columns;
+	int failed = 0;
+
+	/* Check the dimensions. X either has one row that is shared by
+	 * every series or one row for each series */
+	if ((X->rows != 1 && X->rows != numSeries) || X->columns != numPoints) {
+		fprintf (stderr, "ERROR:  Invalid dimensions for x values in function %s.\n", name);
+		return DIMENSION_ERROR;
+	}
+
+	if (coefficients->rows != numSeries || coefficients->columns != 2) {
+		fprintf (stderr, "ERROR:  Coefficient matrix must be %dx2 in function %s.\n", numSeries, name);
+		return DIMENSION_ERROR;
+	}
+
+	if (residuals != 0x00 && (residuals->rows != numSeries || residuals->columns != numPoints)) {
+		fprintf (stderr, "ERROR:  Residual matrix must be %dx%d in function %s.\n", numSeries, numPoints, name);
+		return DIMENSION_ERROR;
+	}
+
+	#pragma omp parallel
+	{
+		double *u;
+		double *v;
+		double uMean, vMean;
+		double sxx, sxy;
+		double A, B;
+		double *x, *y;
+		int s, i;
+
+		/* Each thread gets its own workspace for the linearized values */
+		u = malloc (numPoints * sizeof (double));
+		v = malloc (numPoints * sizeof (double));
+		if (u == 0x00 || v == 0x00) {
+			#pragma omp atomic write
+			failed = 1;
+		}
+
+		#pragma omp for schedule(static)
+		for (s = 0; s < numSeries; s++) {
+			if (u == 0x00 || v == 0x00) {
+				continue;
+			}
+
+			x = &X->mat[(X->rows == 1 ? 0 : s) * numPoints];
+			y = &Y->mat[s * numPoints];
+
+			/* Linearize the values. The transforms are kept in their own
+			 * loops so the calls to log can be vectorized. This only happens
+			 * on x86-64 with glibc's libmvec, which math.h only declares when
+			 * Adder is built with -ffast-math, so the loops are scalar
+			 * otherwise */
+			if (logX) {
+				#pragma omp simd
+				for (i = 0; i < numPoints; i++) {
+					u[i] = log (x[i]);
+				}
+			}
+			else {
+				for (i = 0; i < numPoints; i++) {
+					u[i] = x[i];
+				}
+			}
+
+			#pragma omp simd
+			for (i = 0; i < numPoints; i++) {
+				v[i] = log (y[i]);
+			}
+
+			/* Solve the two coefficient least squares problem v = A + B * u
+			 * directly using centered sums, which gives the same solution
+			 * as the QR factorization used by exponentialFit */
+			uMean = 0;
+			vMean = 0;
+			#pragma omp simd reduction(+:uMean,vMean)
+			for (i = 0; i < numPoints; i++) {
+				uMean += u[i];
+				vMean += v[i];
+			}
+
+			uMean /= numPoints;
+			vMean /= numPoints;
+
+			sxx = 0;
+			sxy = 0;
+			#pragma omp simd reduction(+:sxx,sxy)
+			for (i = 0; i < numPoints; i++) {
+				sxx += (u[i] - uMean) * (u[i] - uMean);
+				sxy += (u[i] - uMean) * (v[i] - vMean);
+			}
+
+			/* If the x values are all the same or a y value isn't positive then
+			 * the series can't be fitted. Its coefficients are set to NAN. */
+			if (sxx == 0 || !isfinite (sxy)) {
+				coefficients->mat[2 * s] = NAN;
+				coefficients->mat[2 * s + 1] = NAN;
+
+				if (residuals != 0x00) {
+					for (i = 0; i < numPoints; i++) {
+						residuals->mat[s * numPoints + i] = NAN;
+					}
+				}
+
+				continue;
+			}
+
+			B = sxy / sxx;
+			A = vMean - B * uMean;
+
+			/* Convert the coefficients back so the result is of the form [a b] */
+			coefficients->mat[2 * s] = exp (A);
+			coefficients->mat[2 * s + 1] = B;
+
+			/* Calculate the residuals of the fitted curve in the original
+			 * (not linearized) form, r = y - exp (A + B * u). Like the
+			 * log loops, exp is only vectorized with libmvec and -ffast-math */
+			if (residuals != 0x00) {
+				#pragma omp simd
+				for (i = 0; i < numPoints; i++) {
+					residuals->mat[s * numPoints + i] = y[i] - exp (A + B * u[i]);
+				}
+			}
+		}
+
+		free (u);
+		free (v);
+	}
+
+	if (failed) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function %s.\n", name);
+		return INIT_ERROR;
+	}
+
+	return 0;
+}
+
+/* Fit the exponential curve y = a*e^(bx) to many independent data series.
+ * Each row of Y is a series of y values. X has either one row of x values
+ * that is used for every series or one row for each series.
+ * The coefficients of series i are stored in row i of coefficients as [a b],
+ * which must be allocated by the caller with Y->rows rows and 2 columns.
+ * If residuals is not NULL it must have the same dimensions as Y and row i
+ * is set to y - a*e^(bx) for series i.
+ * The series are fitted in parallel and X and Y are not overwritten.
+ * Series that can't be fitted have their coefficients set to NAN. */
+int
+exponentialFitBatch (adder_matrix *X, adder_matrix *Y, adder_matrix *coefficients, adder_matrix *residuals)
+{
+	return logLinearFitBatch (X, Y, coefficients, residuals, 0, "exponentialFitBatch");
+}
+
+/* Fit the power curve y = a*x^b to many independent data series.
+ * The arguments are the same as for exponentialFitBatch. Both the x and
+ * y values must be positive. */
+int
+powerFitBatch (adder_matrix *X, adder_matrix *Y, adder_matrix *coefficients, adder_matrix *residuals)
+{
+	return logLinearFitBatch (X, Y, coefficients, residuals, 1, "powerFitBatch");
+}
+
 /* Calculate the eigenvalues of the matrix */
 adder_vector *
 eigenValues (adder_matrix *M)
@@ -783,3 +1343,498 @@ matrixNorm (adder_matrix *M)
 
 	return res;
 }
+
+/* Calculate the 1-norm of a matrix, which is the largest absolute column sum */
+double
+matrixNorm1 (adder_matrix *M)
+{
+	const int m = M->rows;
+	const int n = M->columns;
+	double *sums;
+	double res = 0;
+	int numThreads = 1;
+	int i, j, t;
+
+#ifdef _OPENMP
+	numThreads = omp_get_max_threads ();
+#endif
+
+	/* One row of column sums per thread, on the heap since wide matrices
+	 * would overflow the stacks of the threads */
+	sums = calloc ((long int)numThreads * n, sizeof (double));
+	if (sums == 0x00) {
+		/* Fall back to LAPACK if there isn't memory for the column sums */
+		return LAPACKE_dlange (LAPACK_ROW_MAJOR, '1', m, n, M->mat, n);
+	}
+
+	/* Each thread sums the rows it is given into its own row of sums */
+	#pragma omp parallel private(i, j) num_threads(numThreads)
+	{
+		double *partial = sums;
+
+#ifdef _OPENMP
+		partial = &sums[(long int)omp_get_thread_num () * n];
+#endif
+
+		#pragma omp for schedule(static)
+		for (i = 0; i < m; i++) {
+			#pragma omp simd
+			for (j = 0; j < n; j++) {
+				partial[j] += fabs (M->mat[(long int)i * n + j]);
+			}
+		}
+	}
+
+	/* Combine the partial sums in thread order */
+	for (t = 1; t < numThreads; t++) {
+		#pragma omp simd
+		for (j = 0; j < n; j++) {
+			sums[j] += sums[(long int)t * n + j];
+		}
+	}
+
+	for (j = 0; j < n; j++) {
+		if (sums[j] > res) {
+			res = sums[j];
+		}
+	}
+
+	free (sums);
+
+	return res;
+}
+
+/* Calculate the infinity-norm of a matrix, which is the largest absolute row sum */
+double
+matrixNormInf (adder_matrix *M)
+{
+	const int m = M->rows;
+	const int n = M->columns;
+	double res = 0;
+	double sum;
+	int i, j;
+
+	#pragma omp parallel for private(j, sum) reduction(max:res) schedule(static)
+	for (i = 0; i < m; i++) {
+		sum = 0;
+
+		#pragma omp simd reduction(+:sum)
+		for (j = 0; j < n; j++) {
+			sum += fabs (M->mat[i * n + j]);
+		}
+
+		if (sum > res) {
+			res = sum;
+		}
+	}
+
+	return res;
+}
+
+/* Calculate the max-norm of a matrix, which is the largest absolute element */
+double
+matrixNormMax (adder_matrix *M)
+{
+	const long int size = (long int)M->rows * M->columns;
+	double res = 0;
+	long int i;
+
+	#pragma omp parallel for simd reduction(max:res) schedule(static)
+	for (i = 0; i < size; i++) {
+		res = fabs (M->mat[i]) > res ? fabs (M->mat[i]) : res;
+	}
+
+	return res;
+}
+
+/* Estimate the 2-norm (largest singular value) of a matrix using power iteration on M' * M.
+ * tol is the relative change in the estimate between iterations at which to stop
+ * iterLimit is the maximum number of iterations
+ * This costs two matrix-vector products per iteration instead of a full SVD. The
+ * estimate is never larger than the true 2-norm and converges quickly unless the
+ * largest singular values are close together. */
+double
+matrixNorm2Estimate (adder_matrix *M, double tol, int iterLimit)
+{
+	const int m = M->rows;
+	const int n = M->columns;
+	double *v;
+	double *w;
+	double norm;
+	double est = 0;
+	double estOld;
+	unsigned long int seed = 0x2545f4914f6cdd1d;
+	int i;
+
+	v = malloc (n * sizeof (double));
+	if (v == 0x00) {
+		return -1;
+	}
+
+	w = malloc (m * sizeof (double));
+	if (w == 0x00) {
+		free (v);
+		return -1;
+	}
+
+	/* Start with a fixed pseudo-random vector so it is very unlikely to be
+	 * orthogonal to the leading right singular vector and results are repeatable */
+	for (i = 0; i < n; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		v[i] = 1 + (double)(seed >> 11) / (double)(1ul << 53);
+	}
+
+	norm = cblas_dnrm2 (n, v, 1);
+	if (norm == 0) {
+		free (v);
+		free (w);
+		return 0;
+	}
+
+	cblas_dscal (n, 1 / norm, v, 1);
+
+	for (i = 0; i < iterLimit; i++) {
+		/* w = M * v, and ||w|| is the current estimate */
+		cblas_dgemv (CblasRowMajor, CblasNoTrans, m, n, 1.0, M->mat, n, v, 1, 0.0, w, 1);
+
+		estOld = est;
+		est = cblas_dnrm2 (m, w, 1);
+		if (est == 0) {
+			break;
+		}
+
+		if (fabs (est - estOld) <= tol * est) {
+			break;
+		}
+
+		/* v = M' * w / ||M' * w|| */
+		cblas_dgemv (CblasRowMajor, CblasTrans, m, n, 1.0, M->mat, n, w, 1, 0.0, v, 1);
+
+		norm = cblas_dnrm2 (n, v, 1);
+		if (norm == 0) {
+			break;
+		}
+
+		cblas_dscal (n, 1 / norm, v, 1);
+	}
+
+	free (v);
+	free (w);
+
+	return est;
+}
+
+/* Estimate the 1-norm condition number of a matrix from its LU factorization.
+ * This uses Higham's version of Hager's method (LAPACK's dgecon), which
+ * needs only a few solves with the existing factors, so the cost is O(n^2)
+ * instead of the O(n^3) needed to compute the inverse or the SVD.
+ * Returns the estimate, or -1 if it couldn't be calculated. */
+double
+luConditionEstimate (adder_lu *lu)
+{
+	double rcond;
+	lapack_int err;
+
+	err = LAPACKE_dgecon (LAPACK_ROW_MAJOR, '1', lu->n, lu->LU, lu->n, lu->anorm, &rcond);
+	if (err != 0) {
+		fprintf (stderr, "ERROR:  Illegal argument number %d in LAPACKE_dgecon subroutine in function luConditionEstimate.\n", -1 * err);
+		return -1;
+	}
+
+	/* An exactly singular matrix has an infinite condition number */
+	if (rcond == 0) {
+		return INFINITY;
+	}
+
+	return 1 / rcond;
+}
+
+/* Estimate the 1-norm condition number of a square matrix.
+ * If the factorization will be used again then use luInit and
+ * luConditionEstimate instead so the matrix is only factored once. */
+double
+conditionEstimate (adder_matrix *M)
+{
+	adder_lu *lu;
+	double res;
+
+	lu = luInit (M);
+	if (lu == 0x00) {
+		return -1;
+	}
+
+	res = luConditionEstimate (lu);
+	deleteLU (lu);
+
+	return res;
+}
+
+/****************************
+ * Complex linear algebra *
+ ****************************/
+
+/* Solve a complex-valued linear system of equations.
+ * Z and b are not overwritten. */
+adder_complex_vector *
+complexLinearSolve (adder_complex_matrix *Z, adder_complex_vector *b)
+{
+	adder_complex_vector *res;
+	adder_complex_rect *A;
+	lapack_int n;
+	lapack_int *ipvt;
+	lapack_int err;
+
+	/* Check that the right-side vector (b) is a column vector */
+	if (b->orientation == ROW_VECTOR) {
+		fprintf (stderr, "ERROR:  b vector must be a column vector.\n");
+		return NULL;
+	}
+
+	/* The matrix has to be square and match the size of b */
+	if (Z->rows != Z->columns || Z->rows != b->size) {
+		fprintf (stderr, "System is either over-determined, under-determined, or matrix and vector dimension mismatch.\n");
+		return NULL;
+	}
+
+	n = Z->rows;
+
+	res = complexVectorInit2 (COLUMN_VECTOR, n);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	memcpy (res->vect, b->vect, n * sizeof (adder_complex_rect));
+
+	/* Create a copy of Z so it doesn't get overwritten by the factorization */
+	A = malloc (n * n * sizeof (adder_complex_rect));
+	if (A == 0x00) {
+		deleteComplexVector (res);
+		return NULL;
+	}
+
+	memcpy (A, Z->mat, n * n * sizeof (adder_complex_rect));
+
+	ipvt = malloc (n * sizeof (lapack_int));
+	if (ipvt == 0x00) {
+		deleteComplexVector (res);
+		free (A);
+		return NULL;
+	}
+
+	/* adder_complex_rect has the same layout as lapack_complex_double */
+	err = LAPACKE_zgesv (LAPACK_ROW_MAJOR, n, 1, (lapack_complex_double *)A, n, ipvt, (lapack_complex_double *)res->vect, 1);
+
+	free (A);
+	free (ipvt);
+
+	if (err < 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		deleteComplexVector (res);
+		return NULL;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "Factorization creates singular matrix.\n");
+		deleteComplexVector (res);
+		return NULL;
+	}
+
+	return res;
+}
+
+/* Calculate the inverse of a complex-valued matrix */
+adder_complex_matrix *
+complexInverse (adder_complex_matrix *Z)
+{
+	adder_complex_matrix *res;
+	lapack_int *ipvt;
+	lapack_int n;
+	lapack_int err;
+
+	/* If the matrix isn't square then it's inverse can't be calculated */
+	if (Z->rows != Z->columns) {
+		fprintf (stderr, "Dimension error:  Matrix not square.\n");
+		return NULL;
+	}
+
+	n = Z->rows;
+
+	res = complexMatrixInit2 (n, n);
+	if (res == 0x00) {
+		return NULL;
+	}
+
+	memcpy (res->mat, Z->mat, n * n * sizeof (adder_complex_rect));
+
+	ipvt = malloc (n * sizeof (lapack_int));
+	if (ipvt == 0x00) {
+		deleteComplexMatrix (res);
+		return NULL;
+	}
+
+	/* Calculate the LU factorization of the matrix */
+	err = LAPACKE_zgetrf (LAPACK_ROW_MAJOR, n, n, (lapack_complex_double *)res->mat, n, ipvt);
+	if (err == 0) {
+		/* Invert the matrix */
+		err = LAPACKE_zgetri (LAPACK_ROW_MAJOR, n, (lapack_complex_double *)res->mat, n, ipvt);
+	}
+
+	free (ipvt);
+
+	if (err < 0) {
+		fprintf (stderr, "The value of argument %d is illegal\n", -1 * err);
+		deleteComplexMatrix (res);
+		return NULL;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "Matrix is singular.\n");
+		deleteComplexMatrix (res);
+		return NULL;
+	}
+
+	return res;
+}
+
+/* Calculate the singular values of a complex-valued matrix */
+adder_vector *
+complexSvd (adder_complex_matrix *Z)
+{
+	adder_complex_rect *A;
+	adder_vector *s;
+	lapack_int err;
+
+	/* Create a copy of Z so it doesn't get overwritten */
+	A = malloc (Z->rows * Z->columns * sizeof (adder_complex_rect));
+	if (A == 0x00) {
+		return 0x00;
+	}
+
+	memcpy (A, Z->mat, Z->rows * Z->columns * sizeof (adder_complex_rect));
+
+	/* Create the s vector, which holds the singular values of Z */
+	s = vectorInit2 (COLUMN_VECTOR, Z->rows <= Z->columns ? Z->rows : Z->columns);
+	if (s == 0x00) {
+		free (A);
+		return 0x00;
+	}
+
+	/* Only the singular values are needed, so the singular vectors aren't calculated */
+	err = LAPACKE_zgesdd (LAPACK_ROW_MAJOR, 'N', Z->rows, Z->columns, (lapack_complex_double *)A, Z->columns, s->vect, 0x00, 1, 0x00, 1);
+	free (A);
+
+	if (err < 0) {
+		fprintf (stderr, "ERROR:  Illegal argument number %d in SVD subroutine in function complexSvd.\n", -1 * err);
+		deleteVector (s);
+		return 0x00;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "ERROR:  ZBDSDC subroutine did not converge in function complexSvd.\n");
+		deleteVector (s);
+		return 0x00;
+	}
+
+	return s;
+}
+
+/* Calculate the eigenvalues of a Hermitian matrix.
+ * Only the upper triangle of Z is used. The eigenvalues of a Hermitian
+ * matrix are real and are returned in ascending order. */
+adder_vector *
+hermitianEigenValues (adder_complex_matrix *Z)
+{
+	adder_complex_rect *A;
+	adder_vector *res;
+	lapack_int *isuppz;
+	lapack_int n;
+	lapack_int m;
+	lapack_int err;
+
+	/* Check if the matrix is square */
+	if (Z->rows != Z->columns) {
+		fprintf (stderr, "Eigenvalue error:  Matrix is not square.\n");
+		return NULL;
+	}
+
+	n = Z->rows;
+
+	A = malloc (n * n * sizeof (adder_complex_rect));
+	if (A == 0x00) {
+		return NULL;
+	}
+
+	memcpy (A, Z->mat, n * n * sizeof (adder_complex_rect));
+
+	res = vectorInit2 (COLUMN_VECTOR, n);
+	if (res == 0x00) {
+		free (A);
+		return NULL;
+	}
+
+	isuppz = malloc (2 * n * sizeof (lapack_int));
+	if (isuppz == 0x00) {
+		free (A);
+		deleteVector (res);
+		return NULL;
+	}
+
+	/* Calculate all of the eigenvalues using the MRRR algorithm */
+	err = LAPACKE_zheevr (LAPACK_ROW_MAJOR, 'N', 'A', 'U', n, (lapack_complex_double *)A, n, 0, 0, 0, 0, 0, &m, res->vect, 0x00, 1, isuppz);
+
+	free (A);
+	free (isuppz);
+
+	if (err < 0) {
+		fprintf (stderr, "Invalid arguments.\n");
+		deleteVector (res);
+		return NULL;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "Failed to calculate the eigenvalues.\n");
+		deleteVector (res);
+		return NULL;
+	}
+
+	return res;
+}
+
+/* Calculate the dot product of two complex-valued vectors.
+ * The first vector is conjugated, so the result is sum (conj (z1) * z2) */
+int
+complexDotProduct (adder_complex_vector *z1, adder_complex_vector *z2, adder_complex_rect *res)
+{
+	if (z1->size != z2->size) {
+		fprintf (stderr, "ERROR:  Vector sizes do not match\n");
+		return DIMENSION_ERROR;
+	}
+
+	if (z1->orientation != z2->orientation) {
+		fprintf (stderr, "ERROR:  Vector orientations do not match\n");
+		return DIMENSION_ERROR;
+	}
+
+	cblas_zdotc_sub (z1->size, z1->vect, 1, z2->vect, 1, res);
+
+	return 0;
+}
+
+/* Calculate the 2-norm of a complex-valued vector */
+double
+complexVectorNorm (adder_complex_vector *z)
+{
+	return cblas_dznrm2 (z->size, z->vect, 1);
+}
+
+/* Calculate y = alpha * x + y for complex-valued vectors */
+int
+complexAxpy (adder_complex_rect *alpha, adder_complex_vector *x, adder_complex_vector *y)
+{
+	if (x->size != y->size) {
+		fprintf (stderr, "ERROR:  Vector sizes do not match\n");
+		return DIMENSION_ERROR;
+	}
+
+	cblas_zaxpy (x->size, alpha, x->vect, 1, y->vect, 1);
+
+	return 0;
+}
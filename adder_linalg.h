@@ -7,18 +7,35 @@
 
 #include "adder_matrix.h"
 
+/* LU factorization type definition */
+typedef struct
+{
+	double *LU; /* L and U factors stored by rows. L has a unit diagonal that isn't stored */
+	int *ipvt; /* Row pivots */
+	double anorm; /* 1-norm of the factored matrix, used for condition estimates */
+	int n; /* Number of rows and columns */
+} adder_lu;
+
 /* Extra matrix functions */
 adder_matrix * inverse (adder_matrix *m);
 adder_matrix * pseudoinverse (adder_matrix *m);
 
+/* LU factorization */
+adder_lu * luInit (adder_matrix *M);
+void deleteLU (adder_lu *lu);
+adder_vector * luSolve (adder_lu *lu, adder_vector *b);
+
 /* Equation solving */
 adder_vector * linearSolve (adder_matrix *M, adder_vector *b);
 adder_vector * odLinearSolve (adder_matrix *M, adder_vector *b);
 adder_vector * linearLeastSquares (adder_matrix *M, adder_vector *b);
+adder_vector * sketchLeastSquares (adder_matrix *M, adder_vector *b, double tol, int iterLimit);
 
 /* Curve fitting functions */
 adder_vector * exponentialFit (adder_matrix *M, adder_vector *b);
 adder_vector * powerFit (adder_matrix *M, adder_vector *b);
+int exponentialFitBatch (adder_matrix *X, adder_matrix *Y, adder_matrix *coefficients, adder_matrix *residuals);
+int powerFitBatch (adder_matrix *X, adder_matrix *Y, adder_matrix *coefficients, adder_matrix *residuals);
 
 /* Eigenvalues */
 adder_vector * eigenValues (adder_matrix *m);
@@ -29,5 +46,24 @@ adder_vector * svd (adder_matrix *m);
 /* Norms */
 double vectorNorm (adder_vector *v);
 double matrixNorm (adder_matrix *m);
+double matrixNorm1 (adder_matrix *M);
+double matrixNormInf (adder_matrix *M);
+double matrixNormMax (adder_matrix *M);
+double matrixNorm2Estimate (adder_matrix *M, double tol, int iterLimit);
+
+/* Condition number estimates */
+double luConditionEstimate (adder_lu *lu);
+double conditionEstimate (adder_matrix *M);
+
+/* Complex linear algebra */
+adder_complex_vector * complexLinearSolve (adder_complex_matrix *Z, adder_complex_vector *b);
+adder_complex_matrix * complexInverse (adder_complex_matrix *Z);
+adder_vector * complexSvd (adder_complex_matrix *Z);
+adder_vector * hermitianEigenValues (adder_complex_matrix *Z);
+
+/* Complex vector functions */
+int complexDotProduct (adder_complex_vector *z1, adder_complex_vector *z2, adder_complex_rect *res);
+double complexVectorNorm (adder_complex_vector *z);
+int complexAxpy (adder_complex_rect *alpha, adder_complex_vector *x, adder_complex_vector *y);
 
 #endif
@@ -8,9 +8,52 @@
 #ifndef __ADDER_MATH__
 #define __ADDER_MATH__
 
+#include <stddef.h> /* For size_t */
+
+/* Function of one variable. Either set function, or set function to NULL and
+ * set functionParams and params to pass data to the function without global
+ * variables, which makes routines that use it reentrant. Only function is
+ * read when it is not NULL, so code that only assigns function keeps
+ * working. Initialize with adder_function f = {.function = func}; the
+ * positional form {func} also works but warns under -Wextra. */
 typedef struct
 {
 	double (*function)(double x);
+	double (*functionParams)(double x, void *params); /* Used when function is NULL */
+	void *params; /* Passed unchanged to functionParams */
 } adder_function;
 
+/* Evaluate f at x */
+static inline double
+evaluateFunction (adder_function *f, double x)
+{
+	if (f->function != NULL) {
+		return f->function (x);
+	}
+
+	return f->functionParams (x, f->params);
+}
+
+/* Function evaluated at many points with one call, y[i] = f (x[i]) for
+ * i < n. Integration routines pass every point of a rule at once, so the
+ * function can use SIMD math or threads and the call overhead is paid once.
+ * data is passed unchanged. */
+typedef struct
+{
+	void (*function)(const double *x, double *y, size_t n, void *data);
+	void *data;
+} adder_batch_function;
+
+/* Model function y = f(x; params) used for nonlinear curve fitting.
+ * gradient calculates the derivatives of the model with respect to each
+ * parameter and can be NULL, in which case they are calculated numerically.
+ * data is passed unchanged to both functions so the model doesn't need to
+ * use global variables. */
+typedef struct
+{
+	double (*function)(double x, double *params, void *data);
+	void (*gradient)(double x, double *params, double *grad, void *data);
+	void *data;
+} adder_model_function;
+
 #endif
@@ -234,6 +234,40 @@ deleteComplexVector (adder_complex_vector *z)
 	free (z);
 }
 
+/* Create a complex vector that uses values as its elements without copying
+ * them. values must stay allocated until the vector is deleted with
+ * deleteComplexVectorView, which doesn't free them. A double _Complex or
+ * std::complex<double> array can be passed with the casts in complex_interop.h */
+adder_complex_vector *
+complexVectorInitView (int orient, int numElements, adder_complex_rect *values)
+{
+	adder_complex_vector *z;
+
+	if (orient != ROW_VECTOR && orient != COLUMN_VECTOR) {
+		fprintf (stderr, "Invalid orientation.\n");
+		return NULL;
+	}
+
+	z = malloc (sizeof (adder_complex_vector));
+	if (z == 0x00) {
+		fprintf (stderr, "Failed to create complex vector.\n");
+		return NULL;
+	}
+
+	z->vect = values;
+	z->orientation = orient;
+	z->size = numElements;
+
+	return z;
+}
+
+/* Delete a vector created by complexVectorInitView without freeing its values */
+void
+deleteComplexVectorView (adder_complex_vector *z)
+{
+	free (z);
+}
+
 /* Print a complex-valued vector */
 void
 printComplexVector (adder_complex_vector *z)
@@ -528,6 +562,8 @@ complexMatrixInit2 (int numRows, int numColumns)
 
 	Z->rows = numRows;
 	Z->columns = numColumns;
+
+	return Z;
 }
 
 /* Delete a complex-valued matrix */
@@ -538,6 +574,34 @@ deleteComplexMatrix (adder_complex_matrix *Z)
 	free (Z);
 }
 
+/* Create a complex matrix that uses the row-major array values as its
+ * elements without copying them. values must stay allocated until the
+ * matrix is deleted with deleteComplexMatrixView, which doesn't free them */
+adder_complex_matrix *
+complexMatrixInitView (int numRows, int numColumns, adder_complex_rect *values)
+{
+	adder_complex_matrix *Z;
+
+	Z = malloc (sizeof (adder_complex_matrix));
+	if (Z == 0x00) {
+		fprintf (stderr, "Failed to create complex matrix.\n");
+		return NULL;
+	}
+
+	Z->mat = values;
+	Z->rows = numRows;
+	Z->columns = numColumns;
+
+	return Z;
+}
+
+/* Delete a matrix created by complexMatrixInitView without freeing its values */
+void
+deleteComplexMatrixView (adder_complex_matrix *Z)
+{
+	free (Z);
+}
+
 /* Print a complex-valued matrix */
 void
 printComplexMatrix (adder_complex_matrix *Z)
@@ -617,6 +681,167 @@ mmMultiply (adder_matrix *A, adder_matrix *B)
 	return res;
 }
 
+/* Return the stack space, in elements, that chainProduct needs to multiply
+ * matrices i to j, not counting the result. dims holds the count + 1 dimensions */
+static long int
+chainStackSize (int *dims, int *split, int count, int i, int j)
+{
+	long int leftSize, rightSize;
+	long int need, rightNeed;
+	int k;
+
+	if (i == j) {
+		return 0;
+	}
+
+	k = split[i * count + j];
+	leftSize = k > i ? (long int)dims[i] * dims[k + 1] : 0;
+	rightSize = k + 1 < j ? (long int)dims[k + 1] * dims[j + 1] : 0;
+
+	need = leftSize + chainStackSize (dims, split, count, i, k);
+	rightNeed = leftSize + rightSize + chainStackSize (dims, split, count, k + 1, j);
+
+	return need > rightNeed ? need : rightNeed;
+}
+
+/* Multiply matrices i to j in the order given by split and store the result in dst.
+ * Intermediate products are stored in stack, with the left operand first, the
+ * right operand after it, and the space for their own intermediates after that */
+static void
+chainProduct (adder_matrix **matrices, int *dims, int *split, int count, int i, int j, double *dst, double *stack)
+{
+	double *left, *right;
+	long int leftSize;
+	int k;
+
+	k = split[i * count + j];
+
+	if (k > i) {
+		left = stack;
+		leftSize = (long int)dims[i] * dims[k + 1];
+		chainProduct (matrices, dims, split, count, i, k, left, stack + leftSize);
+	}
+	else {
+		left = matrices[i]->mat;
+		leftSize = 0;
+	}
+
+	if (k + 1 < j) {
+		right = stack + leftSize;
+		chainProduct (matrices, dims, split, count, k + 1, j, right, right + (long int)dims[k + 1] * dims[j + 1]);
+	}
+	else {
+		right = matrices[j]->mat;
+	}
+
+	cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasNoTrans, dims[i], dims[j + 1], dims[k + 1], 1.0, left, dims[k + 1], right, dims[j + 1], 0.0, dst, dims[j + 1]);
+}
+
+/* Multiply a chain of count matrices, matrices[0] * matrices[1] * ... * matrices[count - 1].
+ * The order of the products with the fewest operations is found by dynamic
+ * programming on the dimensions, which can be far cheaper than multiplying
+ * from left to right when the shapes differ. All intermediate products share
+ * one workspace allocation. If flops is not NULL then the number of floating
+ * point operations of the chosen order is stored in it. */
+adder_matrix *
+mmMultiplyChain (adder_matrix **matrices, int count, double *flops)
+{
+	adder_matrix *res;
+	double *cost;
+	double *stack;
+	double c;
+	int *dims;
+	int *split;
+	long int stackSize;
+	int i, j, k, len;
+
+	if (count <= 0) {
+		fprintf (stderr, "ERROR:  No matrices to multiply in function mmMultiplyChain.\n");
+		return NULL;
+	}
+
+	/* Check that the dimensions of neighboring matrices match */
+	for (i = 0; i < count - 1; i++) {
+		if (matrices[i]->columns != matrices[i + 1]->rows) {
+			fprintf (stderr, "ERROR:  Dimension of matrix %d is %dx%d and matrix %d is %dx%d\n", i, matrices[i]->rows, matrices[i]->columns, i + 1, matrices[i + 1]->rows, matrices[i + 1]->columns);
+			return NULL;
+		}
+	}
+
+	if (count == 1) {
+		if (flops != NULL) {
+			*flops = 0;
+		}
+
+		return matrixInit (matrices[0]->rows, matrices[0]->columns, matrices[0]->mat);
+	}
+
+	dims = malloc ((count + 1) * sizeof (int));
+	split = malloc (count * count * sizeof (int));
+	cost = malloc (count * count * sizeof (double));
+	if (dims == NULL || split == NULL || cost == NULL) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function mmMultiplyChain.\n");
+		free (dims);
+		free (split);
+		free (cost);
+		return NULL;
+	}
+
+	for (i = 0; i < count; i++) {
+		dims[i] = matrices[i]->rows;
+	}
+
+	dims[count] = matrices[count - 1]->columns;
+
+	/* cost[i][j] is the fewest multiplications needed for matrices i to j,
+	 * and split[i][j] is where the last product divides them */
+	for (i = 0; i < count; i++) {
+		cost[i * count + i] = 0;
+	}
+
+	for (len = 2; len <= count; len++) {
+		for (i = 0; i + len - 1 < count; i++) {
+			j = i + len - 1;
+			cost[i * count + j] = -1;
+			for (k = i; k < j; k++) {
+				c = cost[i * count + k] + cost[(k + 1) * count + j] + (double)dims[i] * dims[k + 1] * dims[j + 1];
+				if (cost[i * count + j] < 0 || c < cost[i * count + j]) {
+					cost[i * count + j] = c;
+					split[i * count + j] = k;
+				}
+			}
+		}
+	}
+
+	if (flops != NULL) {
+		*flops = 2 * cost[count - 1];
+	}
+
+	res = matrixInit2 (dims[0], dims[count]);
+	stackSize = chainStackSize (dims, split, count, 0, count - 1);
+	stack = malloc ((stackSize > 0 ? stackSize : 1) * sizeof (double));
+	if (res == NULL || stack == NULL) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function mmMultiplyChain.\n");
+		if (res != NULL) {
+			deleteMatrix (res);
+		}
+		free (stack);
+		free (dims);
+		free (split);
+		free (cost);
+		return NULL;
+	}
+
+	chainProduct (matrices, dims, split, count, 0, count - 1, res->mat, stack);
+
+	free (stack);
+	free (dims);
+	free (split);
+	free (cost);
+
+	return res;
+}
+
 /* Multiply a complex-valued vector and matrix */
 adder_complex_vector *
 mvMultiplyComplex (adder_complex_matrix *Z, adder_complex_vector *v)
@@ -70,6 +70,8 @@ void printVector (adder_vector *v);
 adder_complex_vector * complexVectorInit (int orient, int numElements, double *realValues, double *imagValues);
 adder_complex_vector * complexVectorInit2 (int orient, int numElements);
 void deleteComplexVector (adder_complex_vector *z);
+adder_complex_vector * complexVectorInitView (int orient, int numElements, adder_complex_rect *values);
+void deleteComplexVectorView (adder_complex_vector *z);
 void printComplexVector (adder_complex_vector *z);
 
 /* Vector setting functions */
@@ -93,11 +95,14 @@ void printMatrix (adder_matrix *m);
 adder_complex_matrix * complexMatrixInit (int numRows, int numColumns, double *realValues, double *imagValues);
 adder_complex_matrix * complexMatrixInit2 (int numRows, int numColumns);
 void deleteComplexMatrix (adder_complex_matrix *Z);
+adder_complex_matrix * complexMatrixInitView (int numRows, int numColumns, adder_complex_rect *values);
+void deleteComplexMatrixView (adder_complex_matrix *Z);
 void printComplexMatrix (adder_complex_matrix *Z);
 
 /* Matrix arithmetic functions */
 adder_vector * mvMultiply (adder_matrix *M, adder_vector *v);
 adder_matrix * mmMultiply (adder_matrix *A, adder_matrix *B);
+adder_matrix * mmMultiplyChain (adder_matrix **matrices, int count, double *flops);
 adder_complex_vector * mvMultiplyComplex (adder_complex_matrix *Z, adder_complex_vector *v);
 adder_complex_matrix * mmMultiplyComplex (adder_complex_matrix *Y, adder_complex_matrix *Z);
 
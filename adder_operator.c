@@ -0,0 +1,299 @@
+/* operator.c
+ * Function definitions for the linear operators in operator.h */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <cblas.h>
+#include "adder_matrix.h"
+#include "adder_operator.h"
+
+/* Factors of a Kronecker or Khatri-Rao product */
+typedef struct
+{
+	adder_matrix *A;
+	adder_matrix *B;
+} product_factors;
+
+/* Create an operator from a matrix-vector product callback.
+ * data is passed to apply and isn't freed when the operator is deleted */
+adder_linear_operator *
+operatorInit (int rows, int columns, adder_matvec_function apply, void *data)
+{
+	adder_linear_operator *op;
+
+	if (rows <= 0 || columns <= 0 || apply == NULL) {
+		fprintf (stderr, "ERROR:  Invalid arguments in function operatorInit.\n");
+		return NULL;
+	}
+
+	op = malloc (sizeof (adder_linear_operator));
+	if (op == NULL) {
+		fprintf (stderr, "Failed to create linear operator.\n");
+		return NULL;
+	}
+
+	op->apply = apply;
+	op->destroy = NULL;
+	op->data = data;
+	op->rows = rows;
+	op->columns = columns;
+
+	return op;
+}
+
+/* Delete a linear operator */
+void
+deleteOperator (adder_linear_operator *op)
+{
+	if (op->destroy != NULL) {
+		op->destroy (op->data);
+	}
+
+	free (op);
+}
+
+/* y = M * x or y = M' * x for a dense matrix */
+static int
+matrixApply (void *data, int transpose, double *x, double *y)
+{
+	adder_matrix *M = data;
+
+	cblas_dgemv (CblasRowMajor, transpose ? CblasTrans : CblasNoTrans, M->rows, M->columns, 1.0, M->mat, M->columns, x, 1, 0.0, y, 1);
+
+	return 0;
+}
+
+/* Create an operator for a dense matrix, so it can be used
+ * wherever an operator is expected. M is not copied */
+adder_linear_operator *
+matrixOperatorInit (adder_matrix *M)
+{
+	return operatorInit (M->rows, M->columns, matrixApply, M);
+}
+
+/* y = (A kron B) * x, or the transpose, without forming the Kronecker product.
+ * With x reshaped to the n x q matrix X, (A kron B) * x is A * X * B' reshaped,
+ * and (A kron B)' * y is A' * Y * B. The two products are done in the order
+ * with fewer operations. */
+static int
+kroneckerApply (void *data, int transpose, double *x, double *y)
+{
+	product_factors *f = data;
+	adder_matrix *A = f->A;
+	adder_matrix *B = f->B;
+	CBLAS_TRANSPOSE transA, transB;
+	double *T;
+	double leftFirst, rightFirst;
+	int m, n, p, q;
+
+	/* Op * x is the m x p matrix op (A) * X * op (B)' where X is n x q */
+	if (transpose) {
+		m = A->columns;
+		n = A->rows;
+		p = B->columns;
+		q = B->rows;
+		transA = CblasTrans;
+		transB = CblasNoTrans;
+	}
+	else {
+		m = A->rows;
+		n = A->columns;
+		p = B->rows;
+		q = B->columns;
+		transA = CblasNoTrans;
+		transB = CblasTrans;
+	}
+
+	leftFirst = (double)m * n * q + (double)m * q * p;
+	rightFirst = (double)n * q * p + (double)m * n * p;
+
+	if (leftFirst <= rightFirst) {
+		/* T = op (A) * X is m x q, then Y = T * op (B)' */
+		T = malloc ((long int)m * q * sizeof (double));
+		if (T == NULL) {
+			fprintf (stderr, "ERROR:  Failed to create workspace in function kroneckerApply.\n");
+			return INIT_ERROR;
+		}
+
+		cblas_dgemm (CblasRowMajor, transA, CblasNoTrans, m, q, n, 1.0, A->mat, A->columns, x, q, 0.0, T, q);
+		cblas_dgemm (CblasRowMajor, CblasNoTrans, transB, m, p, q, 1.0, T, q, B->mat, B->columns, 0.0, y, p);
+	}
+	else {
+		/* T = X * op (B)' is n x p, then Y = op (A) * T */
+		T = malloc ((long int)n * p * sizeof (double));
+		if (T == NULL) {
+			fprintf (stderr, "ERROR:  Failed to create workspace in function kroneckerApply.\n");
+			return INIT_ERROR;
+		}
+
+		cblas_dgemm (CblasRowMajor, CblasNoTrans, transB, n, p, q, 1.0, x, q, B->mat, B->columns, 0.0, T, p);
+		cblas_dgemm (CblasRowMajor, transA, CblasNoTrans, m, p, n, 1.0, A->mat, A->columns, T, p, 0.0, y, p);
+	}
+
+	free (T);
+
+	return 0;
+}
+
+/* Create an operator for the Kronecker product of A (m x n) and B (p x q),
+ * which is (m * p) x (n * q). Applying it costs O(mnq + mpq) or O(nqp + mnp)
+ * operations and O(mq) or O(np) memory instead of O(mnpq) for the full product. */
+adder_linear_operator *
+kroneckerOperatorInit (adder_matrix *A, adder_matrix *B)
+{
+	adder_linear_operator *op;
+	product_factors *f;
+
+	f = malloc (sizeof (product_factors));
+	if (f == NULL) {
+		fprintf (stderr, "Failed to create linear operator.\n");
+		return NULL;
+	}
+
+	f->A = A;
+	f->B = B;
+
+	op = operatorInit (A->rows * B->rows, A->columns * B->columns, kroneckerApply, f);
+	if (op == NULL) {
+		free (f);
+		return NULL;
+	}
+
+	op->destroy = free;
+
+	return op;
+}
+
+/* y = (A khatri-rao B) * x or its transpose for A (m x r) and B (p x r).
+ * Column l of the product is A(:, l) kron B(:, l), so the product times x
+ * is A * diag (x) * B' reshaped to m * p. The transpose times y, with y
+ * reshaped to the m x p matrix Y, is the column sums of A .* (Y * B). */
+static int
+khatriRaoApply (void *data, int transpose, double *x, double *y)
+{
+	product_factors *f = data;
+	adder_matrix *A = f->A;
+	adder_matrix *B = f->B;
+	const int m = A->rows;
+	const int p = B->rows;
+	const int r = A->columns;
+	double *T;
+	int i, l;
+
+	T = malloc ((long int)m * r * sizeof (double));
+	if (T == NULL) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function khatriRaoApply.\n");
+		return INIT_ERROR;
+	}
+
+	if (!transpose) {
+		/* T = A * diag (x), then Y = T * B' */
+		for (i = 0; i < m; i++) {
+			#pragma omp simd
+			for (l = 0; l < r; l++) {
+				T[i * r + l] = A->mat[i * r + l] * x[l];
+			}
+		}
+
+		cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasTrans, m, p, r, 1.0, T, r, B->mat, r, 0.0, y, p);
+	}
+	else {
+		/* T = X * B where X is m x p, then y(l) = sum over i of A(i, l) * T(i, l) */
+		cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasNoTrans, m, r, p, 1.0, x, p, B->mat, r, 0.0, T, r);
+
+		for (l = 0; l < r; l++) {
+			y[l] = 0;
+		}
+
+		for (i = 0; i < m; i++) {
+			#pragma omp simd
+			for (l = 0; l < r; l++) {
+				y[l] += A->mat[i * r + l] * T[i * r + l];
+			}
+		}
+	}
+
+	free (T);
+
+	return 0;
+}
+
+/* Create an operator for the Khatri-Rao (column-wise Kronecker) product of
+ * A (m x r) and B (p x r), which is (m * p) x r */
+adder_linear_operator *
+khatriRaoOperatorInit (adder_matrix *A, adder_matrix *B)
+{
+	adder_linear_operator *op;
+	product_factors *f;
+
+	if (A->columns != B->columns) {
+		fprintf (stderr, "ERROR:  Matrices must have the same number of columns in function khatriRaoOperatorInit.\n");
+		return NULL;
+	}
+
+	f = malloc (sizeof (product_factors));
+	if (f == NULL) {
+		fprintf (stderr, "Failed to create linear operator.\n");
+		return NULL;
+	}
+
+	f->A = A;
+	f->B = B;
+
+	op = operatorInit (A->rows * B->rows, A->columns, khatriRaoApply, f);
+	if (op == NULL) {
+		free (f);
+		return NULL;
+	}
+
+	op->destroy = free;
+
+	return op;
+}
+
+/* Calculate Op * x */
+adder_vector *
+operatorApply (adder_linear_operator *op, adder_vector *x)
+{
+	adder_vector *res;
+
+	if (x->orientation != COLUMN_VECTOR || x->size != op->columns) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function operatorApply.\n");
+		return NULL;
+	}
+
+	res = vectorInit2 (COLUMN_VECTOR, op->rows);
+	if (res == NULL) {
+		return NULL;
+	}
+
+	if (op->apply (op->data, 0, x->vect, res->vect) != 0) {
+		deleteVector (res);
+		return NULL;
+	}
+
+	return res;
+}
+
+/* Calculate Op' * x */
+adder_vector *
+operatorApplyTranspose (adder_linear_operator *op, adder_vector *x)
+{
+	adder_vector *res;
+
+	if (x->orientation != COLUMN_VECTOR || x->size != op->rows) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function operatorApplyTranspose.\n");
+		return NULL;
+	}
+
+	res = vectorInit2 (COLUMN_VECTOR, op->columns);
+	if (res == NULL) {
+		return NULL;
+	}
+
+	if (op->apply (op->data, 1, x->vect, res->vect) != 0) {
+		deleteVector (res);
+		return NULL;
+	}
+
+	return res;
+}
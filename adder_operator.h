@@ -0,0 +1,41 @@
+/* operator.h
+ * Linear operators that are applied through a callback instead of stored as a matrix.
+ *
+ * An operator only has to be able to calculate y = Op * x and y = Op' * x,
+ * which is all iterative methods need. Structured operators such as Kronecker
+ * products can then be applied in far less time and memory than forming them.
+ *
+ * The Kronecker and Khatri-Rao operators keep pointers to their factors, so
+ * the factors must not be deleted before the operator. Vectors are reshaped
+ * by rows, so element i * q + j of a vector is element (i, j) of an n x q matrix. */
+#ifndef ADDER_OPERATOR_H
+#define ADDER_OPERATOR_H
+
+#include "adder_matrix.h"
+
+/* Matrix-vector product callback. Calculates y = Op * x, or y = Op' * x if
+ * transpose is nonzero, and returns 0 on success */
+typedef int (*adder_matvec_function) (void *data, int transpose, double *x, double *y);
+
+/* Linear operator type definition */
+typedef struct
+{
+	adder_matvec_function apply; /* Matrix-vector product */
+	void (*destroy) (void *data); /* Frees data when the operator is deleted, or NULL */
+	void *data; /* Passed to apply */
+	int rows; /* Length of Op * x */
+	int columns; /* Length of x */
+} adder_linear_operator;
+
+/* Initialization functions */
+adder_linear_operator * operatorInit (int rows, int columns, adder_matvec_function apply, void *data);
+adder_linear_operator * matrixOperatorInit (adder_matrix *M);
+adder_linear_operator * kroneckerOperatorInit (adder_matrix *A, adder_matrix *B);
+adder_linear_operator * khatriRaoOperatorInit (adder_matrix *A, adder_matrix *B);
+void deleteOperator (adder_linear_operator *op);
+
+/* Applying operators */
+adder_vector * operatorApply (adder_linear_operator *op, adder_vector *x);
+adder_vector * operatorApplyTranspose (adder_linear_operator *op, adder_vector *x);
+
+#endif
@@ -1,7 +1,12 @@
 /* optimization.c
  * Function definitions for optimization.c */
 #include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy */
+#include <math.h> /* For fabs and sqrt */
+#include <lapacke.h>
 #include "adder_optimization.h"
+#include "adder_differentiate.h"
 
 /* Golden Section search method of a single variable function
  * retValue is used to determine if the x-value or the function value of the minimum should be returned
@@ -23,8 +28,8 @@ goldenSectionSearch (adder_function *f, double a, double b, double stoppingCrite
 		alpha = 0.382 * (b - a) + a;
 		beta = 0.618 * (b - a) + a;
 
-		gA = f->function (alpha);
-		gB = f->function (beta);
+		gA = evaluateFunction (f, alpha);
+		gB = evaluateFunction (f, beta);
 
 		if (gA < gB) {
 			b = beta;
@@ -46,7 +51,7 @@ goldenSectionSearch (adder_function *f, double a, double b, double stoppingCrite
 		return x;
 	}
 	else if (retValue == F_VALUE) {
-		return f->function (x);
+		return evaluateFunction (f, x);
 	}
 	else {
 		fprintf (stderr, "Invalid return value specified. Returning x value.\n");
@@ -90,8 +95,8 @@ fibonacciSearch (adder_function *f, double a, double b, int N, double stoppingCr
 			beta = (fibNums[N - i -1] / fibNums[N - i]) * (b - a) + a;
 		}
 
-		fA = f->function (alpha);
-		fB = f->function (beta);
+		fA = evaluateFunction (f, alpha);
+		fB = evaluateFunction (f, beta);
 
 		if (fA < fB) {
 			b = beta;
@@ -112,7 +117,7 @@ fibonacciSearch (adder_function *f, double a, double b, int N, double stoppingCr
 		return x;
 	}
 	else if (retValue == F_VALUE) {
-		return f->function (x);
+		return evaluateFunction (f, x);
 	}
 	else {
 		fprintf (stderr, "Invalid return value specified. Using x-value.\n");
@@ -141,8 +146,8 @@ equalAreaSearch (adder_function *f, double a, double b, int N, double stoppingCr
 		alpha = (a + b) / 3;
 		beta = 2 * (a + b) / 3;
 
-		fA = f->function (alpha);
-		fB = f->function (beta);
+		fA = evaluateFunction (f, alpha);
+		fB = evaluateFunction (f, beta);
 
 		if (fA < fB) {
 			b = beta;
@@ -163,10 +168,266 @@ equalAreaSearch (adder_function *f, double a, double b, int N, double stoppingCr
 		return x;
 	}
 	else if (retValue == F_VALUE) {
-		return f->function (x);
+		return evaluateFunction (f, x);
 	}
 	else {
 		fprintf (stderr, "Invalid return value specified. Using x-value.\n");
 		return x;
 	}
 }
+
+/*****************************
+ * Nonlinear least squares *
+ *****************************/
+
+/* Calculate the residuals r = y - f(x) and return half their sum of squares */
+static double
+lmResiduals (adder_model_function *f, double *x, double *y, int m, double *params, double *r)
+{
+	double cost = 0;
+	int i;
+
+	#pragma omp parallel for schedule(static) reduction(+:cost)
+	for (i = 0; i < m; i++) {
+		r[i] = y[i] - f->function (x[i], params, f->data);
+		cost += r[i] * r[i];
+	}
+
+	return cost / 2;
+}
+
+/* Levenberg-Marquardt method for fitting a nonlinear model to data
+ * f is the model function. If it has no gradient then the Jacobian
+ * is calculated by finite differences using derivModelJacobian
+ * x and y are the data points
+ * params holds the initial guess of the parameters and is overwritten
+ * with the fitted parameters
+ * tol is the tolerance for the gradient, step size, and change in cost
+ * iterLimit is the maximum number of iterations
+ * stats holds the iteration statistics on return and can be NULL
+ *
+ * Each step solves the damped least squares problem
+ *	min || [J; sqrt(lambda) * D] * delta - [r; 0] ||
+ * using a QR factorization, where D holds the column norms of J. This
+ * avoids forming J' * J, which squares the condition number. The damping
+ * is updated using the gain ratio as described by Nielsen. */
+int
+levenbergMarquardt (adder_model_function *f, adder_vector *x, adder_vector *y, adder_vector *params, double tol, int iterLimit, adder_lm_stats *stats)
+{
+	const int m = x->size;
+	const int n = params->size;
+	double *r; /* Residuals at the current parameters */
+	double *rNew; /* Residuals at the trial parameters */
+	double *J; /* Jacobian of the model at the current parameters */
+	double *A; /* Augmented matrix [J; sqrt(lambda) * D] */
+	double *c; /* Augmented right-side vector [r; 0] */
+	double D[n];
+	double pNew[n];
+	double delta[n];
+	double cost, costNew;
+	double predicted, actual;
+	double gain;
+	double lambda = 1e-3;
+	double nu = 2;
+	double norm, pNorm, stepNorm;
+	double g;
+	double temp;
+	adder_lm_stats s;
+	lapack_int err;
+	int done = 0;
+	int i, j, k;
+
+	/* Check the dimensions of the data */
+	if (y->size != m) {
+		fprintf (stderr, "ERROR:  x and y must have the same number of points in function levenbergMarquardt.\n");
+		return OPT_ERROR;
+	}
+
+	if (m < n) {
+		fprintf (stderr, "ERROR:  Fewer data points than parameters in function levenbergMarquardt.\n");
+		return OPT_ERROR;
+	}
+
+	r = malloc (m * sizeof (double));
+	rNew = malloc (m * sizeof (double));
+	J = malloc (m * n * sizeof (double));
+	A = malloc ((m + n) * n * sizeof (double));
+	c = malloc ((m + n) * sizeof (double));
+	if (r == 0x00 || rNew == 0x00 || J == 0x00 || A == 0x00 || c == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function levenbergMarquardt.\n");
+		free (r);
+		free (rNew);
+		free (J);
+		free (A);
+		free (c);
+		return OPT_ERROR;
+	}
+
+	for (j = 0; j < n; j++) {
+		D[j] = 0;
+	}
+
+	s.iterations = 0;
+	s.functionEvaluations = 1;
+	s.jacobianEvaluations = 0;
+	s.status = LM_MAX_ITERATIONS;
+
+	cost = lmResiduals (f, x->vect, y->vect, m, params->vect, r);
+	s.initialCost = cost;
+
+	while (done == 0 && s.iterations < iterLimit) {
+		/* Calculate the Jacobian at the current parameters */
+		derivModelJacobian (f, x->vect, m, params->vect, n, 0, J);
+		s.jacobianEvaluations++;
+
+		/* Check if the gradient J' * r is small enough */
+		norm = 0;
+		for (j = 0; j < n; j++) {
+			g = 0;
+			for (i = 0; i < m; i++) {
+				g += J[i * n + j] * r[i];
+			}
+
+			if (fabs (g) > norm) {
+				norm = fabs (g);
+			}
+		}
+
+		if (norm <= tol) {
+			s.status = LM_CONVERGED_GRADIENT;
+			break;
+		}
+
+		/* Update the scaling of each parameter using the column norms of J */
+		for (j = 0; j < n; j++) {
+			temp = 0;
+			for (i = 0; i < m; i++) {
+				temp += J[i * n + j] * J[i * n + j];
+			}
+
+			temp = sqrt (temp);
+			if (temp > D[j]) {
+				D[j] = temp;
+			}
+
+			if (D[j] == 0) {
+				D[j] = 1;
+			}
+		}
+
+		/* Try steps until one reduces the cost */
+		while (s.iterations < iterLimit) {
+			s.iterations++;
+
+			/* Create the augmented system */
+			memcpy (A, J, m * n * sizeof (double));
+			for (i = 0; i < n; i++) {
+				for (j = 0; j < n; j++) {
+					A[(m + i) * n + j] = 0;
+				}
+
+				A[(m + i) * n + i] = sqrt (lambda) * D[i];
+			}
+
+			memcpy (c, r, m * sizeof (double));
+			for (i = 0; i < n; i++) {
+				c[m + i] = 0;
+			}
+
+			/* Solve for the step using the QR factorization of the augmented matrix */
+			err = LAPACKE_dgels (LAPACK_ROW_MAJOR, 'N', m + n, n, 1, A, n, c, 1);
+			if (err != 0) {
+				fprintf (stderr, "ERROR:  Could not solve for the step in function levenbergMarquardt.\n");
+				s.status = LM_FAILED;
+				done = 1;
+				break;
+			}
+
+			for (j = 0; j < n; j++) {
+				delta[j] = c[j];
+				pNew[j] = params->vect[j] + delta[j];
+			}
+
+			costNew = lmResiduals (f, x->vect, y->vect, m, pNew, rNew);
+			s.functionEvaluations++;
+
+			/* Predicted reduction of the linear model, which is
+			 * (||r||^2 - ||r - J * delta||^2) / 2 */
+			predicted = 0;
+			for (i = 0; i < m; i++) {
+				temp = 0;
+				for (k = 0; k < n; k++) {
+					temp += J[i * n + k] * delta[k];
+				}
+
+				predicted += temp * (2 * r[i] - temp);
+			}
+
+			predicted /= 2;
+			actual = cost - costNew;
+
+			stepNorm = 0;
+			pNorm = 0;
+			for (j = 0; j < n; j++) {
+				stepNorm += delta[j] * delta[j];
+				pNorm += params->vect[j] * params->vect[j];
+			}
+
+			stepNorm = sqrt (stepNorm);
+			pNorm = sqrt (pNorm);
+
+			if (predicted > 0 && actual > 0) {
+				/* Accept the step and decrease the damping */
+				gain = actual / predicted;
+				temp = 2 * gain - 1;
+				temp = 1 - temp * temp * temp;
+				lambda *= temp > 1.0 / 3 ? temp : 1.0 / 3;
+				nu = 2;
+
+				memcpy (params->vect, pNew, n * sizeof (double));
+				memcpy (r, rNew, m * sizeof (double));
+				cost = costNew;
+
+				if (actual <= tol * (costNew > 0 ? costNew : 1)) {
+					s.status = LM_CONVERGED_COST;
+					done = 1;
+				}
+				else if (stepNorm <= tol * (pNorm + tol)) {
+					s.status = LM_CONVERGED_STEP;
+					done = 1;
+				}
+
+				break;
+			}
+
+			/* Reject the step and increase the damping */
+			if (stepNorm <= tol * (pNorm + tol)) {
+				s.status = LM_CONVERGED_STEP;
+				done = 1;
+				break;
+			}
+
+			lambda *= nu;
+			nu *= 2;
+		}
+	}
+
+	s.finalCost = cost;
+	s.lambda = lambda;
+
+	if (stats != 0x00) {
+		*stats = s;
+	}
+
+	free (r);
+	free (rNew);
+	free (J);
+	free (A);
+	free (c);
+
+	if (s.status == LM_FAILED) {
+		return OPT_ERROR;
+	}
+
+	return OPT_SUCCESS;
+}
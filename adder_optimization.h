@@ -6,6 +6,7 @@
 #define ADDER_OPTIMIZATION_H
 
 #include "adder_math.h"
+#include "adder_matrix.h" /* For adder_vector */
 
 enum
 Errors
@@ -30,9 +31,34 @@ LineSearchAlgorithms
 	EQUAL_AREA = 3
 };
 
+enum
+LMStatus
+{
+	LM_CONVERGED_GRADIENT, /* 0 */
+	LM_CONVERGED_STEP, /* 1 */
+	LM_CONVERGED_COST, /* 2 */
+	LM_MAX_ITERATIONS, /* 3 */
+	LM_FAILED /* 4 */
+};
+
+/* Iteration statistics for nonlinear least squares */
+typedef struct
+{
+	int iterations; /* Number of accepted and rejected steps */
+	int functionEvaluations; /* Number of evaluations of the model at all points */
+	int jacobianEvaluations; /* Number of Jacobian calculations */
+	double initialCost; /* Half the sum of squared residuals for the initial parameters */
+	double finalCost; /* Half the sum of squared residuals for the fitted parameters */
+	double lambda; /* Final damping parameter */
+	int status; /* Reason for stopping, one of LMStatus */
+} adder_lm_stats;
+
 /* Line search methods */
 double goldenSectionSearch (adder_function *f, double a, double b, double stoppingCriteria, int retValue);
 double fibonacciSearch (adder_function *f, double a, double b, int N, double stoppingCriteria, int retValue);
 double equalAreaSearch (adder_function *f, double a, double b, int N, double stoppingCriteria, int retValue);
 
+/* Nonlinear least squares */
+int levenbergMarquardt (adder_model_function *f, adder_vector *x, adder_vector *y, adder_vector *params, double tol, int iterLimit, adder_lm_stats *stats);
+
 #endif
@@ -0,0 +1,762 @@
+/* qr.c
+ * Function definitions for the updatable QR factorization in qr.h
+ *
+ * The row append and row delete algorithms are the same as the LINPACK
+ * routines DCHUD and DCHDD, which update the Cholesky factor R' * R of
+ * M' * M. Since R is also the triangular factor of the QR factorization
+ * of M this updates the QR factorization without storing Q.
+ *
+ * Tall-skinny QR works on the augmented matrix [M b], so the last column
+ * of its triangular factor holds Q' * b and the residual norm. */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy */
+#include <math.h> /* For sqrt and fabs */
+#include <cblas.h>
+#include <lapacke.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "adder_matrix.h"
+#include "adder_qr.h"
+
+/* Calculate the Givens rotation that zeroes b against a.
+ * On return a holds the length of the rotated vector */
+static void
+givens (double *a, double b, double *c, double *s)
+{
+	double r;
+
+	if (b == 0) {
+		*c = 1;
+		*s = 0;
+		return;
+	}
+
+	r = hypot (*a, b);
+	*c = *a / r;
+	*s = b / r;
+	*a = r;
+}
+
+/* Create a QR factorization of the overdetermined system M * x = b.
+ * M and b are not overwritten. */
+adder_qr *
+qrInit (adder_matrix *M, adder_vector *b)
+{
+	adder_qr *qr;
+	adder_matrix *A;
+	double *tau;
+	double *c;
+	int m, n, k;
+	int i, j;
+	lapack_int err;
+
+	m = M->rows;
+	n = M->columns;
+
+	/* Check that M and b have the same number of rows */
+	if (b->size != m) {
+		fprintf (stderr, "ERROR:  Invalid dimensions. Matrix has dimensions %dx%d and vector has dimensions %dx1.\n", m, n, b->size);
+		return NULL;
+	}
+
+	qr = qrInit2 (n);
+	if (qr == NULL) {
+		return NULL;
+	}
+
+	/* Create copies of M and b so they don't get overwritten */
+	A = matrixInit (m, n, M->mat);
+	if (A == NULL) {
+		deleteQR (qr);
+		return NULL;
+	}
+
+	c = malloc (m * sizeof (double));
+	if (c == NULL) {
+		deleteQR (qr);
+		deleteMatrix (A);
+		return NULL;
+	}
+
+	memcpy (c, b->vect, m * sizeof (double));
+
+	k = m < n ? m : n;
+
+	tau = malloc ((k > 0 ? k : 1) * sizeof (double));
+	if (tau == NULL) {
+		deleteQR (qr);
+		deleteMatrix (A);
+		free (c);
+		return NULL;
+	}
+
+	/* Calculate the Householder QR factorization of M */
+	err = LAPACKE_dgeqrf (LAPACK_ROW_MAJOR, m, n, A->mat, n, tau);
+	if (err != 0) {
+		fprintf (stderr, "ERROR:  Illegal argument number %d in LAPACKE_dgeqrf subroutine in function qrInit.\n", -1 * err);
+		deleteQR (qr);
+		deleteMatrix (A);
+		free (c);
+		free (tau);
+		return NULL;
+	}
+
+	/* Calculate Q' * b */
+	err = LAPACKE_dormqr (LAPACK_ROW_MAJOR, 'L', 'T', m, 1, k, A->mat, n, tau, c, 1);
+	if (err != 0) {
+		fprintf (stderr, "ERROR:  Illegal argument number %d in LAPACKE_dormqr subroutine in function qrInit.\n", -1 * err);
+		deleteQR (qr);
+		deleteMatrix (A);
+		free (c);
+		free (tau);
+		return NULL;
+	}
+
+	/* The upper triangle of A now holds R. If there are fewer
+	 * rows than columns then the remaining rows of R stay zero. */
+	for (i = 0; i < k; i++) {
+		for (j = i; j < n; j++) {
+			qr->R[i * n + j] = A->mat[i * n + j];
+		}
+
+		qr->qtb[i] = c[i];
+	}
+
+	/* The rest of Q' * b is the part of b that can't be fitted */
+	for (i = k; i < m; i++) {
+		qr->rss += c[i] * c[i];
+	}
+
+	qr->rows = m;
+
+	deleteMatrix (A);
+	free (c);
+	free (tau);
+
+	return qr;
+}
+
+/* Create an empty QR factorization for a system with numColumns unknowns.
+ * Rows are added to it with qrAppendRow. */
+adder_qr *
+qrInit2 (int numColumns)
+{
+	adder_qr *qr;
+
+	qr = malloc (sizeof (adder_qr));
+	if (qr == NULL) {
+		fprintf (stderr, "Failed to create QR factorization.\n");
+		return NULL;
+	}
+
+	qr->R = calloc (numColumns * numColumns, sizeof (double));
+	if (qr->R == NULL) {
+		fprintf (stderr, "Failed to create QR factorization.\n");
+		free (qr);
+		return NULL;
+	}
+
+	qr->qtb = calloc (numColumns, sizeof (double));
+	if (qr->qtb == NULL) {
+		fprintf (stderr, "Failed to create QR factorization.\n");
+		free (qr->R);
+		free (qr);
+		return NULL;
+	}
+
+	qr->rss = 0;
+	qr->rows = 0;
+	qr->columns = numColumns;
+
+	return qr;
+}
+
+/* Delete a QR factorization */
+void
+deleteQR (adder_qr *qr)
+{
+	free (qr->R);
+	free (qr->qtb);
+	free (qr);
+}
+
+/* Add the equation row * x = b to the factorization.
+ * row must have qr->columns elements */
+int
+qrAppendRow (adder_qr *qr, double *row, double b)
+{
+	const int n = qr->columns;
+	double c[n];
+	double s[n];
+	double xj;
+	double t;
+	int i, j;
+
+	/* Rotate the new row into R one column at a time */
+	for (j = 0; j < n; j++) {
+		xj = row[j];
+
+		/* Apply the previous rotations to this column */
+		for (i = 0; i < j; i++) {
+			t = c[i] * qr->R[i * n + j] + s[i] * xj;
+			xj = c[i] * xj - s[i] * qr->R[i * n + j];
+			qr->R[i * n + j] = t;
+		}
+
+		/* Calculate the rotation that zeroes the new element */
+		givens (&qr->R[j * n + j], xj, &c[j], &s[j]);
+	}
+
+	/* Apply the same rotations to Q' * b. Whatever is left of b
+	 * is the residual of the new equation. */
+	for (i = 0; i < n; i++) {
+		t = c[i] * qr->qtb[i] + s[i] * b;
+		b = c[i] * b - s[i] * qr->qtb[i];
+		qr->qtb[i] = t;
+	}
+
+	qr->rss += b * b;
+	qr->rows++;
+
+	return 0;
+}
+
+/* Remove the equation row * x = b from the factorization.
+ * The equation must have been part of the system and R must be
+ * nonsingular after the row is removed. */
+int
+qrDeleteRow (adder_qr *qr, double *row, double b)
+{
+	const int n = qr->columns;
+	double c[n];
+	double s[n];
+	double alpha;
+	double norm;
+	double scale;
+	double zeta;
+	double xx;
+	double t;
+	int i, j;
+
+	if (qr->rows <= n) {
+		fprintf (stderr, "ERROR:  Deleting a row would make the system underdetermined in function qrDeleteRow.\n");
+		return DIMENSION_ERROR;
+	}
+
+	/* Solve R' * s = row */
+	memcpy (s, row, n * sizeof (double));
+	for (i = 0; i < n; i++) {
+		if (qr->R[i * n + i] == 0) {
+			fprintf (stderr, "ERROR:  Factorization is singular in function qrDeleteRow.\n");
+			return SINGULAR_MATRIX;
+		}
+	}
+
+	cblas_dtrsv (CblasRowMajor, CblasUpper, CblasTrans, CblasNonUnit, n, qr->R, n, s, 1);
+
+	/* If the norm of s isn't less than one then the row isn't in the system */
+	norm = cblas_dnrm2 (n, s, 1);
+	if (norm >= 1) {
+		fprintf (stderr, "ERROR:  Row can't be removed without making the factorization singular in function qrDeleteRow.\n");
+		return SINGULAR_MATRIX;
+	}
+
+	alpha = sqrt (1 - norm * norm);
+
+	/* Calculate the rotations */
+	for (i = n - 1; i >= 0; i--) {
+		scale = alpha + fabs (s[i]);
+		norm = hypot (alpha / scale, s[i] / scale);
+		c[i] = (alpha / scale) / norm;
+		s[i] = (s[i] / scale) / norm;
+		alpha = scale * norm;
+	}
+
+	/* Apply the rotations to R */
+	for (j = 0; j < n; j++) {
+		xx = 0;
+		for (i = j; i >= 0; i--) {
+			t = c[i] * xx + s[i] * qr->R[i * n + j];
+			qr->R[i * n + j] = c[i] * qr->R[i * n + j] - s[i] * xx;
+			xx = t;
+		}
+	}
+
+	/* Apply the rotations to Q' * b */
+	zeta = b;
+	for (i = 0; i < n; i++) {
+		qr->qtb[i] = (qr->qtb[i] - s[i] * zeta) / c[i];
+		zeta = c[i] * zeta - s[i] * qr->qtb[i];
+	}
+
+	/* Remove the contribution of the row from the residual. Rounding
+	 * can make the difference slightly negative when it should be zero. */
+	qr->rss -= zeta * zeta;
+	if (qr->rss < 0) {
+		qr->rss = 0;
+	}
+
+	qr->rows--;
+
+	return 0;
+}
+
+/* Solve the least squares problem using the current factorization.
+ * The coefficients are in the same order as the columns of the system */
+adder_vector *
+qrSolve (adder_qr *qr)
+{
+	const int n = qr->columns;
+	adder_vector *res;
+	int i;
+
+	/* Check that R is nonsingular */
+	for (i = 0; i < n; i++) {
+		if (qr->R[i * n + i] == 0) {
+			fprintf (stderr, "ERROR:  Factorization is singular in function qrSolve.\n");
+			return NULL;
+		}
+	}
+
+	res = vectorInit (COLUMN_VECTOR, n, qr->qtb);
+	if (res == NULL) {
+		fprintf (stderr, "ERROR:  Could not create result vector in function qrSolve.\n");
+		return NULL;
+	}
+
+	/* Solve R * x = Q' * b by back substitution */
+	cblas_dtrsv (CblasRowMajor, CblasUpper, CblasNoTrans, CblasNonUnit, n, qr->R, n, res->vect, 1);
+
+	return res;
+}
+
+/* Calculate the 2-norm of the residual of the current least squares solution */
+double
+qrResidualNorm (adder_qr *qr)
+{
+	return sqrt (qr->rss);
+}
+
+/******************
+ * Tall-skinny QR *
+ ******************/
+
+/* Calculate the triangular factor of the augmented matrix [M b] for the rows
+ * rowStart to rowStart + rowCount - 1 of the system and store it in R, which
+ * is (n + 1) x (n + 1). If there are fewer rows than columns then the rows
+ * of R past the end of the block are zero. */
+static int
+tsqrFactorBlock (adder_matrix *M, adder_vector *b, long int rowStart, int rowCount, double *R)
+{
+	const int n = M->columns;
+	const int n1 = n + 1;
+	const int k = rowCount < n1 ? rowCount : n1;
+	double *A;
+	double tau[n1];
+	lapack_int err;
+	long int i;
+	int j;
+
+	for (i = 0; i < n1 * n1; i++) {
+		R[i] = 0;
+	}
+
+	if (rowCount == 0) {
+		return 0;
+	}
+
+	A = malloc ((long int)rowCount * n1 * sizeof (double));
+	if (A == NULL) {
+		return INIT_ERROR;
+	}
+
+	/* Create the augmented block */
+	for (i = 0; i < rowCount; i++) {
+		memcpy (&A[i * n1], &M->mat[(rowStart + i) * n], n * sizeof (double));
+		A[i * n1 + n] = b->vect[rowStart + i];
+	}
+
+	err = LAPACKE_dgeqrf (LAPACK_ROW_MAJOR, rowCount, n1, A, n1, tau);
+	if (err != 0) {
+		fprintf (stderr, "ERROR:  Illegal argument number %d in LAPACKE_dgeqrf subroutine in function tsqrFactorBlock.\n", -1 * err);
+		free (A);
+		return ARGUMENT_ERROR;
+	}
+
+	for (i = 0; i < k; i++) {
+		for (j = i; j < n1; j++) {
+			R[i * n1 + j] = A[i * n1 + j];
+		}
+	}
+
+	free (A);
+
+	return 0;
+}
+
+/* Number of doubles in the workspace of tsqrCombine */
+#define TSQR_COMBINE_WORK(n1) (2 * (long int)(n1) * (n1) + (n1))
+
+/* Combine two (n + 1) x (n + 1) triangular factors by calculating the
+ * QR factorization of [R1; R2]. The result is stored in R1. work holds
+ * TSQR_COMBINE_WORK (n1) doubles, and is allocated by the caller so the
+ * combination can run on threads with small stacks. */
+static int
+tsqrCombine (int n1, double *R1, double *R2, double *work)
+{
+	double *A = work;
+	double *tau = &work[2 * n1 * n1];
+	lapack_int err;
+	int i, j;
+
+	memcpy (A, R1, n1 * n1 * sizeof (double));
+	memcpy (&A[n1 * n1], R2, n1 * n1 * sizeof (double));
+
+	err = LAPACKE_dgeqrf (LAPACK_ROW_MAJOR, 2 * n1, n1, A, n1, tau);
+	if (err != 0) {
+		fprintf (stderr, "ERROR:  Illegal argument number %d in LAPACKE_dgeqrf subroutine in function tsqrCombine.\n", -1 * err);
+		return ARGUMENT_ERROR;
+	}
+
+	for (i = 0; i < n1; i++) {
+		for (j = 0; j < n1; j++) {
+			R1[i * n1 + j] = j >= i ? A[i * n1 + j] : 0;
+		}
+	}
+
+	return 0;
+}
+
+/* Calculate the triangular factor of [M b] by splitting the rows into
+ * numBlocks blocks that are factored in parallel, and then combining the
+ * factors pairwise in a binary tree. The result is stored in R. */
+static int
+tsqrReduce (adder_matrix *M, adder_vector *b, int numBlocks, double *R)
+{
+	const int n1 = M->columns + 1;
+	const long int m = M->rows;
+	double *factors;
+	double *work;
+	long int blockSize;
+	int err = 0;
+	int blockErr;
+	int stride;
+	int i;
+
+	if (numBlocks < 1) {
+		numBlocks = 1;
+	}
+
+	/* Each block needs at least n + 1 rows to be worth factoring separately */
+	if (numBlocks > m / n1) {
+		numBlocks = m / n1 > 0 ? m / n1 : 1;
+	}
+
+	factors = malloc ((long int)numBlocks * n1 * n1 * sizeof (double));
+	if (factors == NULL) {
+		return INIT_ERROR;
+	}
+
+	/* One workspace for each pair on the first level of the tree, which
+	 * has the most pairs */
+	work = malloc ((numBlocks / 2 > 0 ? numBlocks / 2 : 1) * TSQR_COMBINE_WORK (n1) * sizeof (double));
+	if (work == NULL) {
+		free (factors);
+		return INIT_ERROR;
+	}
+
+	blockSize = m / numBlocks;
+
+	/* Factor the blocks. The last block also gets the remaining rows. The
+	 * error codes are positive, so the largest one is returned unchanged */
+	#pragma omp parallel for private(blockErr) schedule(static) reduction(max:err)
+	for (i = 0; i < numBlocks; i++) {
+		blockErr = tsqrFactorBlock (M, b, i * blockSize, i == numBlocks - 1 ? m - i * blockSize : blockSize, &factors[(long int)i * n1 * n1]);
+		if (blockErr > err) {
+			err = blockErr;
+		}
+	}
+
+	/* Combine the factors in a binary tree. The pairs on each level are independent */
+	for (stride = 1; stride < numBlocks && err == 0; stride *= 2) {
+		#pragma omp parallel for private(blockErr) schedule(static) reduction(max:err)
+		for (i = 0; i < numBlocks - stride; i += 2 * stride) {
+			blockErr = tsqrCombine (n1, &factors[(long int)i * n1 * n1], &factors[(long int)(i + stride) * n1 * n1], &work[i / (2 * stride) * TSQR_COMBINE_WORK (n1)]);
+			if (blockErr > err) {
+				err = blockErr;
+			}
+		}
+	}
+
+	memcpy (R, factors, n1 * n1 * sizeof (double));
+	free (factors);
+	free (work);
+
+	return err;
+}
+
+/* Create an empty tall-skinny QR factorization for a system with numColumns unknowns.
+ * Blocks of rows are added to it with tsqrAddBlock. */
+adder_tsqr *
+tsqrInit (int numColumns)
+{
+	adder_tsqr *ts;
+
+	ts = malloc (sizeof (adder_tsqr));
+	if (ts == NULL) {
+		fprintf (stderr, "Failed to create TSQR factorization.\n");
+		return NULL;
+	}
+
+	/* 64 levels is enough for 2^64 blocks */
+	ts->numLevels = 64;
+	ts->levels = calloc (ts->numLevels, sizeof (double *));
+	if (ts->levels == NULL) {
+		fprintf (stderr, "Failed to create TSQR factorization.\n");
+		free (ts);
+		return NULL;
+	}
+
+	ts->columns = numColumns;
+	ts->rows = 0;
+
+	return ts;
+}
+
+/* Delete a tall-skinny QR factorization */
+void
+deleteTSQR (adder_tsqr *ts)
+{
+	int i;
+
+	for (i = 0; i < ts->numLevels; i++) {
+		free (ts->levels[i]);
+	}
+
+	free (ts->levels);
+	free (ts);
+}
+
+/* Add the block of equations M * x = b to the factorization.
+ * The block is factored in parallel and then merged with the blocks that
+ * were already added, so at most one factor per level is kept in memory. */
+int
+tsqrAddBlock (adder_tsqr *ts, adder_matrix *M, adder_vector *b)
+{
+	const int n1 = ts->columns + 1;
+	double *carry;
+	double *work;
+	int numBlocks = 1;
+	int err;
+	int k;
+
+	/* Check the dimensions */
+	if (M->columns != ts->columns || M->rows != b->size) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function tsqrAddBlock.\n");
+		return DIMENSION_ERROR;
+	}
+
+	carry = malloc (n1 * n1 * sizeof (double));
+	if (carry == NULL) {
+		return INIT_ERROR;
+	}
+
+#ifdef _OPENMP
+	numBlocks = omp_get_max_threads ();
+#endif
+
+	err = tsqrReduce (M, b, numBlocks, carry);
+	if (err != 0) {
+		free (carry);
+		return err;
+	}
+
+	work = malloc (TSQR_COMBINE_WORK (n1) * sizeof (double));
+	if (work == NULL) {
+		free (carry);
+		return INIT_ERROR;
+	}
+
+	/* Merge the new factor into the levels like adding one to a binary counter */
+	for (k = 0; k < ts->numLevels; k++) {
+		if (ts->levels[k] == NULL) {
+			ts->levels[k] = carry;
+			break;
+		}
+
+		err = tsqrCombine (n1, ts->levels[k], carry, work);
+		free (carry);
+		if (err != 0) {
+			free (work);
+			return err;
+		}
+
+		carry = ts->levels[k];
+		ts->levels[k] = NULL;
+	}
+
+	free (work);
+	ts->rows += M->rows;
+
+	return 0;
+}
+
+/* Combine all of the levels into a single triangular factor without
+ * changing the factorization, so more blocks can still be added */
+static double *
+tsqrCollapse (adder_tsqr *ts)
+{
+	const int n1 = ts->columns + 1;
+	double *R;
+	double *work;
+	int found = 0;
+	int k;
+
+	R = calloc (n1 * n1, sizeof (double));
+	if (R == NULL) {
+		return NULL;
+	}
+
+	work = malloc (TSQR_COMBINE_WORK (n1) * sizeof (double));
+	if (work == NULL) {
+		free (R);
+		return NULL;
+	}
+
+	for (k = 0; k < ts->numLevels; k++) {
+		if (ts->levels[k] == NULL) {
+			continue;
+		}
+
+		if (found == 0) {
+			memcpy (R, ts->levels[k], n1 * n1 * sizeof (double));
+			found = 1;
+		}
+
+		else if (tsqrCombine (n1, R, ts->levels[k], work) != 0) {
+			free (R);
+			free (work);
+			return NULL;
+		}
+	}
+
+	free (work);
+
+	return R;
+}
+
+/* Solve the least squares problem for all of the blocks added so far.
+ * The coefficients are in the same order as the columns of the system */
+adder_vector *
+tsqrSolve (adder_tsqr *ts)
+{
+	const int n = ts->columns;
+	const int n1 = n + 1;
+	adder_vector *res;
+	double *R;
+	int i;
+
+	R = tsqrCollapse (ts);
+	if (R == NULL) {
+		fprintf (stderr, "ERROR:  Failed to combine factors in function tsqrSolve.\n");
+		return NULL;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (R[i * n1 + i] == 0) {
+			fprintf (stderr, "ERROR:  Factorization is singular in function tsqrSolve.\n");
+			free (R);
+			return NULL;
+		}
+	}
+
+	res = vectorInit2 (COLUMN_VECTOR, n);
+	if (res == NULL) {
+		free (R);
+		return NULL;
+	}
+
+	/* The last column of the augmented factor holds Q' * b */
+	for (i = 0; i < n; i++) {
+		res->vect[i] = R[i * n1 + n];
+	}
+
+	cblas_dtrsv (CblasRowMajor, CblasUpper, CblasNoTrans, CblasNonUnit, n, R, n1, res->vect, 1);
+
+	free (R);
+
+	return res;
+}
+
+/* Calculate the 2-norm of the residual of the least squares solution */
+double
+tsqrResidualNorm (adder_tsqr *ts)
+{
+	const int n1 = ts->columns + 1;
+	double *R;
+	double res;
+
+	R = tsqrCollapse (ts);
+	if (R == NULL) {
+		return -1;
+	}
+
+	/* The last diagonal element of the augmented factor is the residual norm */
+	res = fabs (R[n1 * n1 - 1]);
+	free (R);
+
+	return res;
+}
+
+/* Solve the overdetermined least squares problem M * x = b using tall-skinny QR.
+ * The rows are split into numBlocks blocks that are factored in parallel. If
+ * numBlocks isn't positive then one block per thread is used.
+ * This is much faster than linearLeastSquares when M has many more rows than
+ * columns. M and b are not overwritten. */
+adder_vector *
+tsqrLeastSquares (adder_matrix *M, adder_vector *b, int numBlocks)
+{
+	adder_tsqr *ts;
+	adder_vector *res;
+	int err;
+
+	/* Check the dimensions */
+	if (M->rows != b->size) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function tsqrLeastSquares.\n");
+		return NULL;
+	}
+
+	if (numBlocks < 1) {
+		numBlocks = 1;
+#ifdef _OPENMP
+		numBlocks = omp_get_max_threads ();
+#endif
+	}
+
+	ts = tsqrInit (M->columns);
+	if (ts == NULL) {
+		return NULL;
+	}
+
+	ts->levels[0] = malloc ((M->columns + 1) * (M->columns + 1) * sizeof (double));
+	if (ts->levels[0] == NULL) {
+		deleteTSQR (ts);
+		return NULL;
+	}
+
+	err = tsqrReduce (M, b, numBlocks, ts->levels[0]);
+	if (err != 0) {
+		fprintf (stderr, "ERROR:  Failed to factor the system in function tsqrLeastSquares.\n");
+		deleteTSQR (ts);
+		return NULL;
+	}
+
+	ts->rows = M->rows;
+
+	res = tsqrSolve (ts);
+	deleteTSQR (ts);
+
+	return res;
+}
@@ -0,0 +1,56 @@
+/* qr.h
+ * Updatable QR factorization for linear least squares problems.
+ *
+ * Only the triangular factor R and the transformed right-side vector Q' * b
+ * are kept, so rows can be appended to or deleted from the system in O(n^2)
+ * time using Givens rotations instead of refactoring the whole matrix.
+ * The solution coefficients are in the same order as the columns of the
+ * matrix, which matches linearLeastSquares. */
+#ifndef ADDER_QR_H
+#define ADDER_QR_H
+
+#include "adder_matrix.h"
+
+/* QR factorization type definition */
+typedef struct
+{
+	double *R; /* n x n upper triangular factor stored by rows */
+	double *qtb; /* First n elements of Q' * b */
+	double rss; /* Residual sum of squares of the current system */
+	int rows; /* Number of equations currently in the factorization */
+	int columns; /* Number of unknowns (n) */
+} adder_qr;
+
+/* Tall-skinny QR type definition.
+ * Each level k holds the (n + 1) x (n + 1) triangular factor of the augmented
+ * matrix [M b] for 2^k blocks, or NULL, like the digits of a binary counter. */
+typedef struct
+{
+	double **levels; /* Triangular factors waiting to be combined */
+	int numLevels; /* Number of allocated levels */
+	int columns; /* Number of unknowns (n) */
+	long int rows; /* Number of equations added so far */
+} adder_tsqr;
+
+/* Initialization functions */
+adder_qr * qrInit (adder_matrix *M, adder_vector *b);
+adder_qr * qrInit2 (int numColumns);
+void deleteQR (adder_qr *qr);
+
+/* Updating functions */
+int qrAppendRow (adder_qr *qr, double *row, double b);
+int qrDeleteRow (adder_qr *qr, double *row, double b);
+
+/* Solving functions */
+adder_vector * qrSolve (adder_qr *qr);
+double qrResidualNorm (adder_qr *qr);
+
+/* Tall-skinny QR functions */
+adder_tsqr * tsqrInit (int numColumns);
+void deleteTSQR (adder_tsqr *ts);
+int tsqrAddBlock (adder_tsqr *ts, adder_matrix *M, adder_vector *b);
+adder_vector * tsqrSolve (adder_tsqr *ts);
+double tsqrResidualNorm (adder_tsqr *ts);
+adder_vector * tsqrLeastSquares (adder_matrix *M, adder_vector *b, int numBlocks);
+
+#endif
@@ -0,0 +1,268 @@
+/* rls.c
+ * Function definitions for the recursive least squares estimator in rls.h
+ *
+ * For a new observation x' * theta = y the update is
+ *	k = P * x / (lambda + x' * P * x)
+ *	theta = theta + k * (y - x' * theta)
+ *	P = (P - k * x' * P) / lambda
+ * which costs O(n^2) instead of solving the whole system again. */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy */
+#include <math.h> /* For fabs */
+#include <cblas.h>
+#include <lapacke.h>
+#include "adder_matrix.h"
+#include "adder_rls.h"
+
+/* Create a recursive least squares estimator with numColumns coefficients.
+ * lambda is the forgetting factor, where 1 weights all observations equally
+ * and smaller values discount old observations exponentially.
+ * delta is the initial diagonal of P. Large values (e.g. 1e6) mean the initial
+ * coefficients of zero are not trusted and the estimator adapts quickly. */
+adder_rls *
+rlsInit (int numColumns, double lambda, double delta)
+{
+	adder_rls *rls;
+
+	/* Check that the forgetting factor is valid */
+	if (lambda <= 0 || lambda > 1) {
+		fprintf (stderr, "ERROR:  Forgetting factor must be in (0, 1] in function rlsInit.\n");
+		return NULL;
+	}
+
+	if (delta <= 0) {
+		fprintf (stderr, "ERROR:  Initial covariance must be positive in function rlsInit.\n");
+		return NULL;
+	}
+
+	rls = malloc (sizeof (adder_rls));
+	if (rls == NULL) {
+		fprintf (stderr, "Failed to create RLS estimator.\n");
+		return NULL;
+	}
+
+	rls->P = malloc (numColumns * numColumns * sizeof (double));
+	if (rls->P == NULL) {
+		fprintf (stderr, "Failed to create RLS estimator.\n");
+		free (rls);
+		return NULL;
+	}
+
+	rls->theta = malloc (numColumns * sizeof (double));
+	if (rls->theta == NULL) {
+		fprintf (stderr, "Failed to create RLS estimator.\n");
+		free (rls->P);
+		free (rls);
+		return NULL;
+	}
+
+	rls->work = malloc (numColumns * sizeof (double));
+	if (rls->work == NULL) {
+		fprintf (stderr, "Failed to create RLS estimator.\n");
+		free (rls->P);
+		free (rls->theta);
+		free (rls);
+		return NULL;
+	}
+
+	rls->factor = malloc (numColumns * numColumns * sizeof (double));
+	if (rls->factor == NULL) {
+		fprintf (stderr, "Failed to create RLS estimator.\n");
+		free (rls->P);
+		free (rls->theta);
+		free (rls->work);
+		free (rls);
+		return NULL;
+	}
+
+	rls->columns = numColumns;
+	rls->lambda = lambda;
+	rls->delta = delta;
+
+	/* Re-stabilize once per thousand updates by default when
+	 * forgetting is used, since that is when P can drift */
+	if (lambda < 1) {
+		rls->stabilizeInterval = 1000;
+	}
+	else {
+		rls->stabilizeInterval = 0;
+	}
+
+	rlsReset (rls);
+
+	return rls;
+}
+
+/* Delete a recursive least squares estimator */
+void
+deleteRLS (adder_rls *rls)
+{
+	free (rls->P);
+	free (rls->theta);
+	free (rls->work);
+	free (rls->factor);
+	free (rls);
+}
+
+/* Reset the estimator to its initial state */
+void
+rlsReset (adder_rls *rls)
+{
+	const int n = rls->columns;
+	int i, j;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n; j++) {
+			rls->P[i * n + j] = 0;
+		}
+
+		rls->P[i * n + i] = rls->delta;
+		rls->theta[i] = 0;
+	}
+
+	rls->count = 0;
+}
+
+/* Set the number of updates between re-stabilizations of P.
+ * An interval of 0 disables re-stabilization */
+void
+rlsSetStabilizeInterval (adder_rls *rls, int interval)
+{
+	rls->stabilizeInterval = interval;
+}
+
+/* Update the estimator with the observation row * theta = b.
+ * row must have rls->columns elements */
+int
+rlsUpdate (adder_rls *rls, double *row, double b)
+{
+	const int n = rls->columns;
+	double *Px = rls->work;
+	double denom;
+	double err;
+
+	/* Px = P * x */
+	cblas_dsymv (CblasRowMajor, CblasUpper, n, 1.0, rls->P, n, row, 1, 0.0, Px, 1);
+
+	/* denom = lambda + x' * P * x */
+	denom = rls->lambda + cblas_ddot (n, row, 1, Px, 1);
+	if (denom <= 0) {
+		fprintf (stderr, "ERROR:  Covariance matrix is no longer positive definite in function rlsUpdate.\n");
+		return SINGULAR_MATRIX;
+	}
+
+	/* Prediction error using the current coefficients */
+	err = b - cblas_ddot (n, row, 1, rls->theta, 1);
+
+	/* theta = theta + P * x * err / denom */
+	cblas_daxpy (n, err / denom, Px, 1, rls->theta, 1);
+
+	/* P = (P - P * x * x' * P / denom) / lambda.
+	 * Since P is symmetric this is a symmetric rank-1 update */
+	cblas_dsyr (CblasRowMajor, CblasUpper, n, -1.0 / denom, Px, 1, rls->P, n);
+	if (rls->lambda != 1) {
+		cblas_dscal (n * n, 1.0 / rls->lambda, rls->P, 1);
+	}
+
+	rls->count++;
+
+	/* Periodically make sure P is still positive definite */
+	if (rls->stabilizeInterval > 0 && rls->count % rls->stabilizeInterval == 0) {
+		return rlsStabilize (rls);
+	}
+
+	return 0;
+}
+
+/* Update the estimator with every row of the system M * theta = b in order */
+int
+rlsUpdateBatch (adder_rls *rls, adder_matrix *M, adder_vector *b)
+{
+	int err;
+	int i;
+
+	/* Check the dimensions of the system */
+	if (M->columns != rls->columns || M->rows != b->size) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function rlsUpdateBatch.\n");
+		return DIMENSION_ERROR;
+	}
+
+	for (i = 0; i < M->rows; i++) {
+		err = rlsUpdate (rls, &M->mat[i * M->columns], b->vect[i]);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+/* Re-stabilize the inverse covariance matrix.
+ * Rounding errors, especially with a forgetting factor and poorly
+ * exciting data, can make P lose positive definiteness, which makes
+ * the estimator diverge. If a Cholesky factorization of P fails then
+ * its diagonal is loaded until it is positive definite again. */
+int
+rlsStabilize (adder_rls *rls)
+{
+	const int n = rls->columns;
+	double *L = rls->factor;
+	double trace = 0;
+	double load;
+	lapack_int err;
+	int attempt;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		trace += fabs (rls->P[i * n + i]);
+	}
+
+	load = (trace > 0 ? trace / n : rls->delta) * __DBL_EPSILON__ * n;
+
+	for (attempt = 0; attempt < 32; attempt++) {
+		memcpy (L, rls->P, n * n * sizeof (double));
+
+		err = LAPACKE_dpotrf (LAPACK_ROW_MAJOR, 'U', n, L, n);
+		if (err == 0) {
+			return 0;
+		}
+		else if (err < 0) {
+			fprintf (stderr, "ERROR:  Illegal argument number %d in LAPACKE_dpotrf subroutine in function rlsStabilize.\n", -1 * err);
+			return ARGUMENT_ERROR;
+		}
+
+		/* Load the diagonal and try again */
+		for (i = 0; i < n; i++) {
+			rls->P[i * n + i] += load;
+		}
+
+		load *= 10;
+	}
+
+	/* If loading didn't help then start over from the current coefficients */
+	fprintf (stderr, "WARNING:  Covariance matrix reset in function rlsStabilize.\n");
+	for (i = 0; i < n * n; i++) {
+		rls->P[i] = 0;
+	}
+
+	for (i = 0; i < n; i++) {
+		rls->P[i * n + i] = rls->delta;
+	}
+
+	return 0;
+}
+
+/* Return a copy of the current coefficients */
+adder_vector *
+rlsCoefficients (adder_rls *rls)
+{
+	return vectorInit (COLUMN_VECTOR, rls->columns, rls->theta);
+}
+
+/* Calculate the predicted value row * theta using the current coefficients */
+double
+rlsPredict (adder_rls *rls, double *row)
+{
+	return cblas_ddot (rls->columns, row, 1, rls->theta, 1);
+}
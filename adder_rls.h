@@ -0,0 +1,42 @@
+/* rls.h
+ * Recursive least squares estimator.
+ *
+ * The estimator keeps the inverse covariance matrix P = (M' * M)^-1 and the
+ * current coefficients, and updates both in O(n^2) time for every new
+ * observation. Observations are rows of the same matrix that would be
+ * passed to linearLeastSquares, so the coefficients are in the same order. */
+#ifndef ADDER_RLS_H
+#define ADDER_RLS_H
+
+#include "adder_matrix.h"
+
+/* Recursive least squares type definition */
+typedef struct
+{
+	double *P; /* n x n inverse covariance matrix. Only the upper triangle is used */
+	double *theta; /* Current coefficients */
+	double *work; /* Holds P * x for the current update */
+	double *factor; /* n x n workspace for the Cholesky factor in rlsStabilize */
+	double lambda; /* Forgetting factor in (0, 1]. 1 means no forgetting */
+	double delta; /* Initial value of the diagonal of P */
+	int columns; /* Number of coefficients (n) */
+	long int count; /* Number of observations processed */
+	int stabilizeInterval; /* Number of updates between re-stabilizations. 0 disables it */
+} adder_rls;
+
+/* Initialization functions */
+adder_rls * rlsInit (int numColumns, double lambda, double delta);
+void deleteRLS (adder_rls *rls);
+void rlsReset (adder_rls *rls);
+void rlsSetStabilizeInterval (adder_rls *rls, int interval);
+
+/* Updating functions */
+int rlsUpdate (adder_rls *rls, double *row, double b);
+int rlsUpdateBatch (adder_rls *rls, adder_matrix *M, adder_vector *b);
+int rlsStabilize (adder_rls *rls);
+
+/* Getter functions */
+adder_vector * rlsCoefficients (adder_rls *rls);
+double rlsPredict (adder_rls *rls, double *row);
+
+#endif
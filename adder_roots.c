@@ -25,13 +25,13 @@ bisection (adder_function *f, double lGuess, double rGuess, double tol, unsigned
 	double fc; /* Value of the function at c */
 	unsigned int i;
 
-	fa = f->function (a);
-	fb = f->function (b);
+	fa = evaluateFunction (f, a);
+	fb = evaluateFunction (f, b);
 
 	/* Main algorithm */
 	for (i = 0; i < iterLimit; i++) {
 		c = (a + b) / 2;
-		fc = f->function (c);
+		fc = evaluateFunction (f, c);
 
 		if (fabs (fc) < tol) {
 			break;
@@ -70,8 +70,8 @@ regulaFalsi (adder_function *f, double lGuess, double rGuess, double tol, unsign
 	int i;
 
 	/* Calculate the intial values of the endpoints */
-	f0 = f->function (x0);
-	f1 = f->function (x1);
+	f0 = evaluateFunction (f, x0);
+	f1 = evaluateFunction (f, x1);
 
 	/* Check if the endpoints are the solution */
 	if (f0 == 0) {
@@ -86,7 +86,7 @@ regulaFalsi (adder_function *f, double lGuess, double rGuess, double tol, unsign
 	for (i = 0; i < iterLimit; i++) {
 		/* Calculate the next approximation and the value of the function at that point */
 		x2 = x1 - ((x1 - x0) / (f1 - f0)) * f1;
-		f2 = f->function (x2);
+		f2 = evaluateFunction (f, x2);
 
 		/* Check if x2 is within the desired tolerance */
 		if (fabs (f2) < tol) {
@@ -96,11 +96,11 @@ regulaFalsi (adder_function *f, double lGuess, double rGuess, double tol, unsign
 			/* Check the sign of x2 */
 			if (sign (f0, f2) == 1) {
 				x1 = x2;
-				f1 = f->function (x1);
+				f1 = evaluateFunction (f, x1);
 			}
 			else {
 				x0 = x2;
-				f0 = f->function (x0);
+				f0 = evaluateFunction (f, x0);
 			}
 		}
 	}
@@ -128,8 +128,8 @@ steffensen (adder_function *f, double guess, double tol, unsigned int iterLimit)
 
 	/* The algorithm */
 	for (i = 0; i < iterLimit; i++) {
-        fxn = f->function (xn);
-        f1xn = f->function (xn + fxn);
+        fxn = evaluateFunction (f, xn);
+        f1xn = evaluateFunction (f, xn + fxn);
         
         xn1 = xn - (fxn * fxn) / (f1xn - fxn);
         
@@ -168,7 +168,7 @@ newton (adder_function *f, double guess, double h, double tol, unsigned int iter
 
 	/* The algorithm */
 	for (i = 0; i < iterLimit; i++) {
-		fxn = f->function (xn);
+		fxn = evaluateFunction (f, xn);
 		dfxn = derivSymDiff (f, xn, h);
 
 		/* Definition of Newton's Method */
@@ -213,7 +213,7 @@ halley (adder_function *f, double guess, double h, double tol, unsigned int iter
 
 	for (i = 0; i < iterLimit; i++) {
 		/* Calculate the values of the function and its derivatives at zn */
-		fzn = f->function (zn);
+		fzn = evaluateFunction (f, zn);
 		dfzn = derivSymDiff (f, zn, h);
 		ddfzn = derivSecondSymDiff (f, zn, h);
 
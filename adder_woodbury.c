@@ -0,0 +1,418 @@
+/* woodbury.c
+ * Function definitions for the low-rank update routines in woodbury.h */
+#include <stdio.h>
+#include <stdlib.h> /* For malloc and free */
+#include <string.h> /* For memcpy */
+#include <math.h> /* For fabs */
+#include <cblas.h>
+#include <lapacke.h>
+#include "adder_matrix.h"
+#include "adder_linalg.h"
+#include "adder_woodbury.h"
+
+/* Update the inverse of A in place to the inverse of A + U * V'.
+ * U and V are n x k. The cost is O(n^2 * k). */
+int
+inverseUpdate (adder_matrix *Ainv, adder_matrix *U, adder_matrix *V)
+{
+	const int n = Ainv->rows;
+	const int k = U->columns;
+	double *X; /* Ainv * U, n x k */
+	double *Y; /* V' * Ainv, k x n */
+	double *C; /* I + V' * Ainv * U, k x k */
+	lapack_int *ipvt;
+	lapack_int err;
+	int i;
+
+	if (Ainv->rows != Ainv->columns || U->rows != n || V->rows != n || V->columns != k) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function inverseUpdate.\n");
+		return DIMENSION_ERROR;
+	}
+
+	X = malloc ((long int)n * k * sizeof (double));
+	Y = malloc ((long int)n * k * sizeof (double));
+	C = malloc (k * k * sizeof (double));
+	ipvt = malloc (k * sizeof (lapack_int));
+	if (X == 0x00 || Y == 0x00 || C == 0x00 || ipvt == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function inverseUpdate.\n");
+		free (X);
+		free (Y);
+		free (C);
+		free (ipvt);
+		return INIT_ERROR;
+	}
+
+	cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasNoTrans, n, k, n, 1.0, Ainv->mat, n, U->mat, k, 0.0, X, k);
+	cblas_dgemm (CblasRowMajor, CblasTrans, CblasNoTrans, k, n, n, 1.0, V->mat, k, Ainv->mat, n, 0.0, Y, n);
+
+	/* C = I + V' * X */
+	cblas_dgemm (CblasRowMajor, CblasTrans, CblasNoTrans, k, k, n, 1.0, V->mat, k, X, k, 0.0, C, k);
+	for (i = 0; i < k; i++) {
+		C[i * k + i] += 1;
+	}
+
+	/* Y = C^-1 * V' * Ainv */
+	err = LAPACKE_dgesv (LAPACK_ROW_MAJOR, k, n, C, k, ipvt, Y, n);
+	if (err == 0) {
+		/* Ainv = Ainv - X * Y */
+		cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, k, -1.0, X, k, Y, n, 1.0, Ainv->mat, n);
+	}
+
+	free (X);
+	free (Y);
+	free (C);
+	free (ipvt);
+
+	if (err < 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		return ARGUMENT_ERROR;
+	}
+	else if (err > 0) {
+		fprintf (stderr, "ERROR:  Updated matrix is singular in function inverseUpdate.\n");
+		return SINGULAR_MATRIX;
+	}
+
+	return 0;
+}
+
+/* Update the inverse of A in place to the inverse of A + u * v'.
+ * This is the Sherman-Morrison formula and costs O(n^2). */
+int
+inverseUpdateRank1 (adder_matrix *Ainv, adder_vector *u, adder_vector *v)
+{
+	const int n = Ainv->rows;
+	double *x; /* Ainv * u */
+	double *y; /* Ainv' * v */
+	double denom;
+
+	if (Ainv->rows != Ainv->columns || u->size != n || v->size != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function inverseUpdateRank1.\n");
+		return DIMENSION_ERROR;
+	}
+
+	x = malloc (2 * n * sizeof (double));
+	if (x == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function inverseUpdateRank1.\n");
+		return INIT_ERROR;
+	}
+
+	y = x + n;
+
+	cblas_dgemv (CblasRowMajor, CblasNoTrans, n, n, 1.0, Ainv->mat, n, u->vect, 1, 0.0, x, 1);
+	cblas_dgemv (CblasRowMajor, CblasTrans, n, n, 1.0, Ainv->mat, n, v->vect, 1, 0.0, y, 1);
+
+	denom = 1 + cblas_ddot (n, v->vect, 1, x, 1);
+	if (fabs (denom) <= __DBL_EPSILON__ * (1 + fabs (denom - 1))) {
+		fprintf (stderr, "ERROR:  Updated matrix is singular in function inverseUpdateRank1.\n");
+		free (x);
+		return SINGULAR_MATRIX;
+	}
+
+	cblas_dger (CblasRowMajor, n, n, -1.0 / denom, x, 1, y, 1, Ainv->mat, n);
+
+	free (x);
+
+	return 0;
+}
+
+/* Estimate how far a stored inverse has drifted from the inverse of A.
+ * This returns || x - A * Ainv * x ||inf / || x ||inf for a random sign
+ * vector x, which costs two matrix-vector products. A result much larger
+ * than the machine epsilon times the condition number means Ainv should
+ * be recalculated with inverse (). */
+double
+inverseDriftEstimate (adder_matrix *A, adder_matrix *Ainv)
+{
+	const int n = A->rows;
+	double *x;
+	double *y;
+	double drift = 0;
+	unsigned int seed = 12345;
+	int i;
+
+	if (A->rows != A->columns || Ainv->rows != n || Ainv->columns != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function inverseDriftEstimate.\n");
+		return -1;
+	}
+
+	/* An empty inverse cannot drift */
+	if (n <= 0) {
+		return 0;
+	}
+
+	x = malloc (2 * n * sizeof (double));
+	if (x == 0x00) {
+		fprintf (stderr, "ERROR:  Failed to create workspace in function inverseDriftEstimate.\n");
+		return -1;
+	}
+
+	y = x + n;
+
+	/* Random signs from a linear congruential generator */
+	for (i = 0; i < n; i++) {
+		seed = seed * 1103515245 + 12345;
+		x[i] = (seed & 0x10000) ? 1 : -1;
+	}
+
+	cblas_dgemv (CblasRowMajor, CblasNoTrans, n, n, 1.0, Ainv->mat, n, x, 1, 0.0, y, 1);
+	cblas_dgemv (CblasRowMajor, CblasNoTrans, n, n, -1.0, A->mat, n, y, 1, 1.0, x, 1);
+
+	for (i = 0; i < n; i++) {
+		if (fabs (x[i]) > drift) {
+			drift = fabs (x[i]);
+		}
+	}
+
+	free (x);
+
+	return drift;
+}
+
+/* Create an updatable solver for A.
+ * maxRank is the largest rank the accumulated update can have before the
+ * matrix is refactored, which bounds the extra cost of each solve to O(n * maxRank).
+ * driftTol is the largest relative residual || b - A * x || / (|| A || * || x || + || b ||)
+ * accepted before the matrix is refactored, for example 1e-10. */
+adder_woodbury *
+woodburyInit (adder_matrix *A, int maxRank, double driftTol)
+{
+	adder_woodbury *W;
+	int n;
+
+	if (A->rows != A->columns) {
+		fprintf (stderr, "Dimension error:  Matrix not square.\n");
+		return NULL;
+	}
+
+	if (maxRank <= 0) {
+		fprintf (stderr, "ERROR:  Maximum rank must be positive in function woodburyInit.\n");
+		return NULL;
+	}
+
+	n = A->rows;
+
+	W = malloc (sizeof (adder_woodbury));
+	if (W == 0x00) {
+		fprintf (stderr, "Failed to create Woodbury solver.\n");
+		return NULL;
+	}
+
+	W->A = matrixInit (n, n, A->mat);
+	W->U = malloc ((long int)n * maxRank * sizeof (double));
+	W->V = malloc ((long int)n * maxRank * sizeof (double));
+	W->AinvU = malloc ((long int)n * maxRank * sizeof (double));
+	W->C = malloc (maxRank * maxRank * sizeof (double));
+	W->cpvt = malloc (maxRank * sizeof (int));
+	W->work = malloc ((n + maxRank) * sizeof (double));
+	W->lu = 0x00;
+
+	W->n = n;
+	W->maxRank = maxRank;
+	W->driftTol = driftTol;
+	W->rank = 0;
+	W->refactorizations = 0;
+
+	if (W->A == 0x00 || W->U == 0x00 || W->V == 0x00 || W->AinvU == 0x00 || W->C == 0x00 || W->cpvt == 0x00 || W->work == 0x00) {
+		fprintf (stderr, "Failed to create Woodbury solver.\n");
+		deleteWoodbury (W);
+		return NULL;
+	}
+
+	W->anorm = matrixNormInf (W->A);
+
+	W->lu = luInit (W->A);
+	if (W->lu == 0x00) {
+		deleteWoodbury (W);
+		return NULL;
+	}
+
+	return W;
+}
+
+/* Delete an updatable solver */
+void
+deleteWoodbury (adder_woodbury *W)
+{
+	if (W->A != 0x00) {
+		deleteMatrix (W->A);
+	}
+
+	if (W->lu != 0x00) {
+		deleteLU (W->lu);
+	}
+
+	free (W->U);
+	free (W->V);
+	free (W->AinvU);
+	free (W->C);
+	free (W->cpvt);
+	free (W->work);
+	free (W);
+}
+
+/* Factor the current matrix from scratch and discard the accumulated update */
+int
+woodburyRefactor (adder_woodbury *W)
+{
+	if (W->lu != 0x00) {
+		deleteLU (W->lu);
+	}
+
+	W->rank = 0;
+	W->refactorizations++;
+
+	W->lu = luInit (W->A);
+	if (W->lu == 0x00) {
+		fprintf (stderr, "ERROR:  Updated matrix is singular in function woodburyRefactor.\n");
+		return SINGULAR_MATRIX;
+	}
+
+	return 0;
+}
+
+/* Add U * V' to the matrix, where U and V have k columns with leading dimensions ldu and ldv */
+static int
+update (adder_woodbury *W, int k, double *U, int ldu, double *V, int ldv)
+{
+	const int n = W->n;
+	const int m = W->maxRank;
+	lapack_int err;
+	int i, j;
+
+	if (W->lu == 0x00) {
+		fprintf (stderr, "ERROR:  Solver has no valid factorization in function woodburyUpdate.\n");
+		return SINGULAR_MATRIX;
+	}
+
+	/* A = A + U * V' */
+	cblas_dgemm (CblasRowMajor, CblasNoTrans, CblasTrans, n, n, k, 1.0, U, ldu, V, ldv, 1.0, W->A->mat, n);
+	W->anorm = matrixNormInf (W->A);
+
+	/* Refactor instead of letting the update grow past the maximum rank */
+	if (W->rank + k > m) {
+		return woodburyRefactor (W);
+	}
+
+	/* Append the new columns and calculate A0^-1 * U for them */
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < k; j++) {
+			W->U[i * m + W->rank + j] = U[i * ldu + j];
+			W->V[i * m + W->rank + j] = V[i * ldv + j];
+			W->AinvU[i * m + W->rank + j] = U[i * ldu + j];
+		}
+	}
+
+	err = LAPACKE_dgetrs (LAPACK_ROW_MAJOR, 'N', n, k, W->lu->LU, n, W->lu->ipvt, &W->AinvU[W->rank], m);
+	if (err != 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		return ARGUMENT_ERROR;
+	}
+
+	W->rank += k;
+
+	/* Factor the capacitance matrix C = I + V' * A0^-1 * U */
+	cblas_dgemm (CblasRowMajor, CblasTrans, CblasNoTrans, W->rank, W->rank, n, 1.0, W->V, m, W->AinvU, m, 0.0, W->C, W->rank);
+	for (i = 0; i < W->rank; i++) {
+		W->C[i * W->rank + i] += 1;
+	}
+
+	err = LAPACKE_dgetrf (LAPACK_ROW_MAJOR, W->rank, W->rank, W->C, W->rank, W->cpvt);
+
+	/* A singular capacitance matrix means the update can't be represented
+	 * this way, but the updated matrix itself may still be fine */
+	if (err != 0) {
+		return woodburyRefactor (W);
+	}
+
+	return 0;
+}
+
+/* Update the matrix of the solver to A + U * V', where U and V are n x k */
+int
+woodburyUpdate (adder_woodbury *W, adder_matrix *U, adder_matrix *V)
+{
+	if (U->rows != W->n || V->rows != W->n || U->columns != V->columns) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function woodburyUpdate.\n");
+		return DIMENSION_ERROR;
+	}
+
+	return update (W, U->columns, U->mat, U->columns, V->mat, V->columns);
+}
+
+/* Update the matrix of the solver to A + u * v' */
+int
+woodburyUpdateRank1 (adder_woodbury *W, adder_vector *u, adder_vector *v)
+{
+	if (u->size != W->n || v->size != W->n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function woodburyUpdateRank1.\n");
+		return DIMENSION_ERROR;
+	}
+
+	return update (W, 1, u->vect, 1, v->vect, 1);
+}
+
+/* Solve (A0 + U * V') * x = b.
+ * The solution is x = y - A0^-1 * U * C^-1 * V' * y, where y = A0^-1 * b.
+ * If the relative residual of x is larger than driftTol then the matrix is
+ * refactored and the system is solved again. */
+adder_vector *
+woodburySolve (adder_woodbury *W, adder_vector *b)
+{
+	const int n = W->n;
+	const int m = W->maxRank;
+	adder_vector *res;
+	double *z = W->work;
+	double *r = W->work + m;
+	double rnorm = 0, xnorm = 0, bnorm = 0;
+	lapack_int err;
+	int i;
+
+	if (b->orientation == ROW_VECTOR || b->size != n) {
+		fprintf (stderr, "ERROR:  Invalid dimensions in function woodburySolve.\n");
+		return NULL;
+	}
+
+	if (W->lu == 0x00) {
+		fprintf (stderr, "ERROR:  Solver has no valid factorization in function woodburySolve.\n");
+		return NULL;
+	}
+
+	res = luSolve (W->lu, b);
+	if (res == 0x00 || W->rank == 0) {
+		return res;
+	}
+
+	/* z = C^-1 * V' * y */
+	cblas_dgemv (CblasRowMajor, CblasTrans, n, W->rank, 1.0, W->V, m, res->vect, 1, 0.0, z, 1);
+	err = LAPACKE_dgetrs (LAPACK_ROW_MAJOR, 'N', W->rank, 1, W->C, W->rank, W->cpvt, z, 1);
+	if (err != 0) {
+		fprintf (stderr, "Argument %d is invalid.\n", -1 * err);
+		deleteVector (res);
+		return NULL;
+	}
+
+	/* x = y - A0^-1 * U * z */
+	cblas_dgemv (CblasRowMajor, CblasNoTrans, n, W->rank, -1.0, W->AinvU, m, z, 1, 1.0, res->vect, 1);
+
+	/* Check the residual r = b - A * x */
+	memcpy (r, b->vect, n * sizeof (double));
+	cblas_dgemv (CblasRowMajor, CblasNoTrans, n, n, -1.0, W->A->mat, n, res->vect, 1, 1.0, r, 1);
+
+	for (i = 0; i < n; i++) {
+		rnorm = fabs (r[i]) > rnorm ? fabs (r[i]) : rnorm;
+		xnorm = fabs (res->vect[i]) > xnorm ? fabs (res->vect[i]) : xnorm;
+		bnorm = fabs (b->vect[i]) > bnorm ? fabs (b->vect[i]) : bnorm;
+	}
+
+	if (rnorm > W->driftTol * (W->anorm * xnorm + bnorm)) {
+		deleteVector (res);
+
+		if (woodburyRefactor (W) != 0) {
+			return NULL;
+		}
+
+		return luSolve (W->lu, b);
+	}
+
+	return res;
+}
@@ -0,0 +1,50 @@
+/* woodbury.h
+ * Low-rank updates of inverses and linear solvers.
+ *
+ * When A changes to A + U * V', where U and V are n x k, the Sherman-Morrison-
+ * Woodbury formula
+ *	(A + U * V')^-1 = A^-1 - A^-1 * U * (I + V' * A^-1 * U)^-1 * V' * A^-1
+ * gives the new inverse or solution in O(n^2 * k) time instead of the O(n^3)
+ * of starting over. Rounding errors grow with every update, so the solver
+ * checks the residual of each solution and refactors when it gets too large. */
+#ifndef ADDER_WOODBURY_H
+#define ADDER_WOODBURY_H
+
+#include "adder_matrix.h"
+#include "adder_linalg.h"
+
+/* Updatable linear solver type definition.
+ * The solver keeps the LU factorization of a base matrix A0 and the
+ * accumulated update U * V' so that A = A0 + U * V'. */
+typedef struct
+{
+	adder_matrix *A; /* Current matrix, used for residual checks and refactoring */
+	adder_lu *lu; /* LU factorization of the base matrix A0 */
+	double *U; /* n x maxRank, accumulated update columns */
+	double *V; /* n x maxRank */
+	double *AinvU; /* A0^-1 * U, n x maxRank */
+	double *C; /* LU factorization of the capacitance matrix I + V' * A0^-1 * U */
+	int *cpvt; /* Pivots for C */
+	double *work; /* n + maxRank elements */
+	double anorm; /* Infinity-norm of A */
+	double driftTol; /* Largest relative residual accepted before refactoring */
+	int rank; /* Number of update columns since the last refactorization */
+	int maxRank; /* Refactor instead of letting the rank exceed this */
+	int n; /* Number of rows and columns */
+	int refactorizations; /* Number of refactorizations so far */
+} adder_woodbury;
+
+/* Updating a stored inverse */
+int inverseUpdate (adder_matrix *Ainv, adder_matrix *U, adder_matrix *V);
+int inverseUpdateRank1 (adder_matrix *Ainv, adder_vector *u, adder_vector *v);
+double inverseDriftEstimate (adder_matrix *A, adder_matrix *Ainv);
+
+/* Updatable linear solver */
+adder_woodbury * woodburyInit (adder_matrix *A, int maxRank, double driftTol);
+void deleteWoodbury (adder_woodbury *W);
+int woodburyUpdate (adder_woodbury *W, adder_matrix *U, adder_matrix *V);
+int woodburyUpdateRank1 (adder_woodbury *W, adder_vector *u, adder_vector *v);
+int woodburyRefactor (adder_woodbury *W);
+adder_vector * woodburySolve (adder_woodbury *W, adder_vector *b);
+
+#endif
@@ -0,0 +1,448 @@
+/* test_complex_array.c
+ * Accuracy test for the array functions in complex_array.h.
+ *
+ * Every array function is compared against the C library (atan2, hypot,
+ * sincos, cexp, csqrt, clog, and complex arithmetic) on random arguments in
+ * all four quadrants, on points along the axes, and on signed zeros,
+ * infinities, and NaNs. Both accuracy tiers of the polar conversions are
+ * tested. The random arrays are long enough to be split between threads and
+ * the special arrays are short and not a multiple of the vector length, so
+ * both the vector loops and the scalar paths are covered.
+ *
+ * Build and run from the top of the source tree with
+ *   gcc -std=gnu99 -O2 -fno-math-errno -fopenmp -I. tests/test_complex_array.c \
+ *       adder_complex_array.c adder_complex.c adder_matrix.c -lopenblas -llapacke -lm \
+ *       -o test_complex_array
+ *   ./test_complex_array
+ * The largest error of each function is printed, and the exit status is 1
+ * if any error is above its bound. */
+#define _GNU_SOURCE /* For sincos */
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+#include <complex.h>
+#include "adder_complex.h"
+#include "adder_complex_array.h"
+
+/* Long enough to use several threads and blocks */
+#define RANDOM_SIZE 100000
+
+/* Error bounds. Errors of the full tier are in units in the last place of
+ * the result, or of the magnitude of a complex result. The fast tier is
+ * documented with an absolute error */
+#define FULL_BOUND 4.0
+#define FAST_BOUND 1e-7
+
+#define SPECIAL_SIZE(a) ((int)(sizeof (a) / sizeof (a[0])))
+
+static int failures = 0;
+
+/* Random number in [lo, hi) */
+static double
+uniform (double lo, double hi)
+{
+	return lo + (hi - lo) * (rand () / ((double)RAND_MAX + 1));
+}
+
+/* Random number with magnitude between e^-20 and e^20 in any quadrant */
+static adder_complex_rect
+randomRect ()
+{
+	double r = exp (uniform (-20, 20));
+	double t = uniform (-M_PI, M_PI);
+
+	return makeRect (r * cos (t), r * sin (t));
+}
+
+static double
+ulp (double x)
+{
+	x = fabs (x);
+
+	return x < DBL_MIN ? DBL_MIN * DBL_EPSILON : nextafter (x, INFINITY) - x;
+}
+
+/* Zero if got and want are the same special value, including the sign of
+ * zero, and infinite if they are not. Negative if neither is special */
+static double
+specialError (double got, double want)
+{
+	if (isnan (got) || isnan (want)) {
+		return isnan (got) && isnan (want) ? 0 : INFINITY;
+	}
+
+	if (isinf (got) || isinf (want) || got == 0 || want == 0) {
+		return got == want && signbit (got) == signbit (want) ? 0 : INFINITY;
+	}
+
+	return -1;
+}
+
+/* Error of got in units in the last place of want */
+static double
+ulpError (double got, double want)
+{
+	double e = specialError (got, want);
+
+	return e >= 0 ? e : fabs (got - want) / ulp (want);
+}
+
+/* Absolute error of got */
+static double
+absError (double got, double want)
+{
+	double e = specialError (got, want);
+
+	return e >= 0 ? e : fabs (got - want);
+}
+
+/* Error of each part of got in units in the last place of scale, which is
+ * usually the magnitude of the correct result. Zero parts of a finite
+ * nonzero result may have a small error, but not the wrong sign. Parts of
+ * a result with infinite or NaN magnitude are compared one at a time */
+static double
+complexError (adder_complex_rect got, double complex want, double scale)
+{
+	double parts[2][2] = {{got.real, creal (want)}, {got.imag, cimag (want)}};
+	double e, worst = 0;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		double g = parts[i][0];
+		double w = parts[i][1];
+
+		if (isfinite (scale) && scale > 0 && isfinite (g) && isfinite (w)) {
+			e = fabs (g - w) / ulp (scale);
+			if ((g == 0 || w == 0) && g != w && signbit (g) != signbit (w)) {
+				e = INFINITY;
+			}
+		}
+		else {
+			e = ulpError (g, w);
+		}
+
+		worst = fmax (worst, e);
+	}
+
+	return worst;
+}
+
+static double complex
+toComplex (adder_complex_rect z)
+{
+	return CMPLX (z.real, z.imag);
+}
+
+/* Print the largest error of a function and count it if it is too large */
+static void
+report (const char *name, const char *cases, double err, double bound)
+{
+	int pass = err <= bound;
+
+	printf ("%-22s %-8s max error %-10.3g bound %-8.3g %s\n", name, cases, err, bound, pass ? "ok" : "FAILED");
+	if (!pass) {
+		failures++;
+	}
+}
+
+/* Print the argument of every element that is outside the bound */
+static void
+detail (const char *name, adder_complex_rect a, double err, double bound)
+{
+	if (!(err <= bound)) {
+		printf ("  %s (%g, %g): error %g\n", name, a.real, a.imag, err);
+	}
+}
+
+/* Test every function that takes one rectangular array */
+static void
+testRect (adder_complex_rect *a, int n, const char *cases)
+{
+	adder_complex_rect *c = malloc (n * sizeof (adder_complex_rect));
+	adder_complex_polar *p = malloc (n * sizeof (adder_complex_polar));
+	double *r = malloc (n * sizeof (double));
+	double err, worst;
+	int i, accuracy;
+
+	if (c == NULL || p == NULL || r == NULL) {
+		fprintf (stderr, "ERROR:  Failed to allocate test arrays.\n");
+		exit (1);
+	}
+
+	/* Angles */
+	complexArrayArg (r, a, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		err = ulpError (r[i], atan2 (a[i].imag, a[i].real));
+		detail ("complexArrayArg", a[i], err, FULL_BOUND);
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayArg", cases, worst, FULL_BOUND);
+
+	/* Magnitudes */
+	complexArrayAbs (r, a, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		err = ulpError (r[i], hypot (a[i].real, a[i].imag));
+		detail ("complexArrayAbs", a[i], err, FULL_BOUND);
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayAbs", cases, worst, FULL_BOUND);
+
+	/* Conversion to polar form in both tiers */
+	for (accuracy = COMPLEX_ACCURACY_FULL; accuracy <= COMPLEX_ACCURACY_FAST; accuracy++) {
+		double bound = accuracy == COMPLEX_ACCURACY_FAST ? FAST_BOUND : FULL_BOUND;
+		const char *name = accuracy == COMPLEX_ACCURACY_FAST ? "complexArrayToPolar fast" : "complexArrayToPolar";
+
+		complexArrayToPolar (p, a, n, accuracy);
+		for (i = 0, worst = 0; i < n; i++) {
+			double angle = atan2 (a[i].imag, a[i].real);
+
+			if (accuracy == COMPLEX_ACCURACY_FAST) {
+				err = absError (p[i].angle, angle);
+			}
+			else {
+				err = ulpError (p[i].angle, angle);
+			}
+
+			/* Magnitudes are calculated the same way in both tiers */
+			err = fmax (err, ulpError (p[i].mag, hypot (a[i].real, a[i].imag)) * bound / FULL_BOUND);
+			detail (name, a[i], err, bound);
+			worst = fmax (worst, err);
+		}
+		report (name, cases, worst, bound);
+	}
+
+	/* Functions with complex results */
+	complexArraySqrt (c, a, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		double complex want = csqrt (toComplex (a[i]));
+
+		err = complexError (c[i], want, cabs (want));
+		detail ("complexArraySqrt", a[i], err, FULL_BOUND);
+		worst = fmax (worst, err);
+	}
+	report ("complexArraySqrt", cases, worst, FULL_BOUND);
+
+	/* The real part is the log of a rounded magnitude, so near |a| = 1 its
+	 * error is absolute and is measured against 1 */
+	complexArrayLog (c, a, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		double complex want = clog (toComplex (a[i]));
+
+		err = complexError (c[i], want, fmax (cabs (want), 1));
+		detail ("complexArrayLog", a[i], err, FULL_BOUND);
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayLog", cases, worst, FULL_BOUND);
+
+	complexArrayConj (c, a, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		err = complexError (c[i], conj (toComplex (a[i])), cabs (toComplex (a[i])));
+		detail ("complexArrayConj", a[i], err, 0);
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayConj", cases, worst, 0);
+
+	free (c);
+	free (p);
+	free (r);
+}
+
+/* Test e^a. The real parts are kept small enough for the result not to
+ * overflow */
+static void
+testExp (adder_complex_rect *a, int n, const char *cases)
+{
+	adder_complex_rect *c = malloc (n * sizeof (adder_complex_rect));
+	double err, worst = 0;
+	int i;
+
+	if (c == NULL) {
+		fprintf (stderr, "ERROR:  Failed to allocate test arrays.\n");
+		exit (1);
+	}
+
+	complexArrayExp (c, a, n);
+	for (i = 0; i < n; i++) {
+		double complex want = cexp (toComplex (a[i]));
+
+		err = complexError (c[i], want, cabs (want));
+		detail ("complexArrayExp", a[i], err, FULL_BOUND);
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayExp", cases, worst, FULL_BOUND);
+
+	free (c);
+}
+
+/* Test conversion to rectangular form against mag * sincos (angle) */
+static void
+testPolar (adder_complex_polar *a, int n, const char *cases)
+{
+	adder_complex_rect *c = malloc (n * sizeof (adder_complex_rect));
+	double err, worst;
+	int i, accuracy;
+
+	if (c == NULL) {
+		fprintf (stderr, "ERROR:  Failed to allocate test arrays.\n");
+		exit (1);
+	}
+
+	for (accuracy = COMPLEX_ACCURACY_FULL; accuracy <= COMPLEX_ACCURACY_FAST; accuracy++) {
+		double bound = accuracy == COMPLEX_ACCURACY_FAST ? FAST_BOUND : FULL_BOUND;
+		const char *name = accuracy == COMPLEX_ACCURACY_FAST ? "complexArrayToRect fast" : "complexArrayToRect";
+
+		complexArrayToRect (c, a, n, accuracy);
+		for (i = 0, worst = 0; i < n; i++) {
+			double s, co;
+
+			sincos (a[i].angle, &s, &co);
+			err = complexError (c[i], CMPLX (a[i].mag * co, a[i].mag * s), a[i].mag);
+			if (accuracy == COMPLEX_ACCURACY_FAST && isfinite (a[i].mag) && a[i].mag > 0) {
+				/* Absolute error of sin and cos */
+				err *= ulp (a[i].mag) / a[i].mag;
+			}
+
+			detail (name, makeRect (a[i].mag, a[i].angle), err, bound);
+			worst = fmax (worst, err);
+		}
+		report (name, cases, worst, bound);
+	}
+
+	free (c);
+}
+
+/* Test the arithmetic functions against complex arithmetic in C. They use
+ * the textbook formulas, like rectMul and rectDiv, so the arguments must
+ * not overflow or underflow when squared */
+static void
+testArithmetic (adder_complex_rect *a, adder_complex_rect *b, int n, const char *cases)
+{
+	adder_complex_rect *c = malloc (n * sizeof (adder_complex_rect));
+	double err, worst;
+	int i;
+
+	if (c == NULL) {
+		fprintf (stderr, "ERROR:  Failed to allocate test arrays.\n");
+		exit (1);
+	}
+
+	complexArrayAdd (c, a, b, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		err = complexError (c[i], toComplex (a[i]) + toComplex (b[i]), 1);
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayAdd", cases, worst, 0);
+
+	complexArraySub (c, a, b, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		err = complexError (c[i], toComplex (a[i]) - toComplex (b[i]), 1);
+		worst = fmax (worst, err);
+	}
+	report ("complexArraySub", cases, worst, 0);
+
+	complexArrayMul (c, a, b, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		double complex want = toComplex (a[i]) * toComplex (b[i]);
+
+		err = complexError (c[i], want, cabs (want));
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayMul", cases, worst, FULL_BOUND);
+
+	complexArrayDiv (c, a, b, n);
+	for (i = 0, worst = 0; i < n; i++) {
+		double complex want = toComplex (a[i]) / toComplex (b[i]);
+
+		err = complexError (c[i], want, cabs (want));
+		worst = fmax (worst, err);
+	}
+	report ("complexArrayDiv", cases, worst, FULL_BOUND);
+
+	free (c);
+}
+
+int
+main ()
+{
+	/* Points on the axes and on the diagonals of each quadrant. These are
+	 * finite and nonzero, so they take the vector paths */
+	adder_complex_rect axes[] = {
+		{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, -0.0}, {-1, -0.0}, {-0.0, 1}, {-0.0, -1},
+		{2.5, 0}, {0, 1e-300}, {-1e300, 0}, {0, -3},
+		{1, 1}, {-1, 1}, {-1, -1}, {1, -1}, {3, 3.0000001}, {-2, 1e-20}, {-2, -1e-20}, {1e-20, -2}
+	};
+
+	/* Signed zeros, infinities, and NaNs on and off the axes, and
+	 * magnitudes that overflow or underflow when squared */
+	adder_complex_rect special[] = {
+		{0, 0}, {-0.0, 0}, {0, -0.0}, {-0.0, -0.0},
+		{INFINITY, 0}, {-INFINITY, 0}, {0, INFINITY}, {0, -INFINITY},
+		{INFINITY, -0.0}, {-INFINITY, -0.0}, {-0.0, INFINITY}, {-0.0, -INFINITY},
+		{INFINITY, INFINITY}, {-INFINITY, INFINITY}, {INFINITY, -INFINITY}, {-INFINITY, -INFINITY},
+		{INFINITY, 1}, {-INFINITY, 1}, {1, INFINITY}, {-1, -INFINITY},
+		{NAN, 0}, {0, NAN}, {NAN, 1}, {-1, NAN}, {NAN, INFINITY}, {INFINITY, NAN}, {NAN, NAN},
+		{1e-310, 1e-310}, {-1e-310, 2e-320}, {1e300, -1e300}, {-1e200, 1e200}
+	};
+
+	/* e^a along the axes and at special values */
+	adder_complex_rect expSpecial[] = {
+		{0, 0}, {-0.0, 0}, {0, -0.0}, {-0.0, -0.0}, {1, 0}, {-1, -0.0}, {0, M_PI}, {0, -M_PI_2},
+		{700, 0}, {-745, 0}, {2, 1e5}, {-3, -1e7}, {1, 1e300},
+		{INFINITY, 0}, {-INFINITY, 0}, {INFINITY, -0.0}, {-INFINITY, -0.0},
+		{INFINITY, 1}, {-INFINITY, 1}, {INFINITY, -2}, {-INFINITY, -2},
+		{0, INFINITY}, {1, -INFINITY}, {0, NAN}, {NAN, 0}, {NAN, -0.0}, {NAN, 1}
+	};
+
+	/* Polar numbers with angles on the axes, outside (-pi, pi], too large
+	 * for the vector reduction, and not finite */
+	adder_complex_polar polarSpecial[] = {
+		{1, 0}, {1, -0.0}, {2, M_PI_2}, {2, -M_PI_2}, {3, M_PI}, {3, -M_PI}, {0, 1}, {-0.0, 1},
+		{1, 7}, {1, -100}, {1, 1e5}, {1, 1e7}, {1, 1e300}, {1, -1e300},
+		{1, INFINITY}, {1, -INFINITY}, {1, NAN}, {NAN, 1}, {INFINITY, 0.5}, {INFINITY, 0}
+	};
+
+	adder_complex_rect *a = malloc (RANDOM_SIZE * sizeof (adder_complex_rect));
+	adder_complex_rect *b = malloc (RANDOM_SIZE * sizeof (adder_complex_rect));
+	adder_complex_polar *p = malloc (RANDOM_SIZE * sizeof (adder_complex_polar));
+	int i;
+
+	if (a == NULL || b == NULL || p == NULL) {
+		fprintf (stderr, "ERROR:  Failed to allocate test arrays.\n");
+		return 1;
+	}
+
+	srand (1);
+
+	for (i = 0; i < RANDOM_SIZE; i++) {
+		a[i] = randomRect ();
+		b[i] = randomRect ();
+	}
+
+	testRect (a, RANDOM_SIZE, "random");
+	testRect (axes, SPECIAL_SIZE (axes), "axes");
+	testRect (special, SPECIAL_SIZE (special), "special");
+
+	testArithmetic (a, b, RANDOM_SIZE, "random");
+	testArithmetic (axes, axes + 12, 8, "axes");
+
+	/* Real parts in [-20, 20], and every tenth angle far outside (-pi, pi] */
+	for (i = 0; i < RANDOM_SIZE; i++) {
+		a[i] = makeRect (uniform (-20, 20), uniform (-M_PI, M_PI) * (i % 10 == 0 ? 1e5 : 1));
+		p[i] = makePolar (exp (uniform (-20, 20)), a[i].imag);
+	}
+
+	testExp (a, RANDOM_SIZE, "random");
+	testExp (expSpecial, SPECIAL_SIZE (expSpecial), "special");
+
+	testPolar (p, RANDOM_SIZE, "random");
+	testPolar (polarSpecial, SPECIAL_SIZE (polarSpecial), "special");
+
+	free (a);
+	free (b);
+	free (p);
+
+	printf (failures ? "%d tests FAILED\n" : "All tests passed\n", failures);
+
+	return failures ? 1 : 0;
+}